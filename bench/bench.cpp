@@ -0,0 +1,537 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <set>
+#include <span>
+#include <vector>
+#include "BST.hpp"
+#include "BTreeBST.hpp"
+#include "CompactBST.hpp"
+#include "ConcurrentBST.hpp"
+#include "PersistentBST.hpp"
+#include "PoolAllocator.hpp"
+#include "ShardedBST.hpp"
+
+using UnbalancedBST = BST<int>;
+using RedBlackBST = BST<int, std::less<int>, std::allocator<int>, RedBlack>;
+using StdSet = std::set<int>;
+using StdMultiset = std::multiset<int>;
+using Frozen = FrozenBST<int>;
+using Compact = CompactBST<int>;
+using Persistent = PersistentBST<int>;
+using BTree = BTreeBST<int>;
+using OrderStatBST =
+    BST<int, std::less<int>, std::allocator<int>, RedBlack, SubtreeSize>;
+using PoolBST = BST<int, std::less<int>, PoolAllocator<int>, RedBlack>;
+
+/** @brief Tag types selecting the order in which keys are inserted. */
+struct Random {};
+struct Sorted {};
+struct Reverse {};
+
+/**
+ * @brief Generates n distinct even keys in the requested order.
+ * Odd values are never present and serve as misses.
+ */
+std::vector<int> MakeKeys(size_t n, Random) {
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = static_cast<int>(2 * i);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+    return keys;
+}
+
+std::vector<int> MakeKeys(size_t n, Sorted) {
+    std::vector<int> keys = MakeKeys(n, Random());
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+std::vector<int> MakeKeys(size_t n, Reverse) {
+    std::vector<int> keys = MakeKeys(n, Sorted());
+    std::reverse(keys.begin(), keys.end());
+    return keys;
+}
+
+/** @brief Builds a container by inserting keys one at a time. */
+template <class Container>
+void Fill(Container& container, const std::vector<int>& keys) {
+    for (int key : keys) {
+        container.insert(key);
+    }
+}
+
+/** @brief Builds a frozen snapshot from the sorted keys. */
+void Fill(Frozen& container, std::vector<int> keys) {
+    std::sort(keys.begin(), keys.end());
+    container = Frozen(keys.begin(), keys.end());
+}
+
+/** @brief Inserts n keys one by one into an empty container. */
+template <class Container, class Order>
+void BM_Insert(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Order());
+    std::optional<Container> container;
+    for (auto _ : state) {
+        container.emplace();
+        Fill(*container, keys);
+        benchmark::DoNotOptimize(*container);
+        state.PauseTiming();
+        container.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/** @brief Looks up every key, either present (hit) or absent (miss). */
+template <class Container, bool Hit>
+void BM_Find(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    Container container;
+    Fill(container, keys);
+    std::vector<int> probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+    if (!Hit) {
+        for (int& probe : probes) {
+            probe += 1;
+        }
+    }
+    for (auto _ : state) {
+        for (int probe : probes) {
+            benchmark::DoNotOptimize(container.find(probe));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+/** @brief Resolves the probes in batches of 4096 with find_batch(). */
+template <class Container>
+void BM_FindBatch(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    Container container;
+    Fill(container, keys);
+    std::vector<int> probes = keys;
+    std::shuffle(probes.begin(), probes.end(), std::mt19937_64(7));
+    constexpr size_t kBatch = 4096;
+    std::vector<typename Container::const_iterator> out(kBatch);
+    const Container& view = container;
+    for (auto _ : state) {
+        for (size_t i = 0; i < probes.size(); i += kBatch) {
+            size_t n = std::min(kBatch, probes.size() - i);
+            view.find_batch(std::span<const int>(probes).subspan(i, n),
+                            std::span(out).first(n));
+            benchmark::DoNotOptimize(out.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+}
+
+/** @brief Appends sorted keys one by one with end() as the hint. */
+template <class Container>
+void BM_Append(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Sorted());
+    std::optional<Container> container;
+    for (auto _ : state) {
+        container.emplace();
+        for (int key : keys) {
+            container->insert(container->end(), key);
+        }
+        benchmark::DoNotOptimize(*container);
+        state.PauseTiming();
+        container.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/**
+ * @brief Looks up keys in ascending order, each lookup either from the root
+ * or (Finger) from the previous hit.
+ */
+template <class Container, bool Finger>
+void BM_FindClustered(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    Container container;
+    Fill(container, keys);
+    std::sort(keys.begin(), keys.end());
+    for (auto _ : state) {
+        auto hint = container.begin();
+        for (int key : keys) {
+            if constexpr (Finger) {
+                hint = container.find_from(hint, key);
+            } else {
+                hint = container.find(key);
+            }
+            benchmark::DoNotOptimize(hint);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/** @brief Runs lower_bound for keys falling between stored elements. */
+template <class Container>
+void BM_LowerBound(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    Container container;
+    Fill(container, keys);
+    for (auto _ : state) {
+        for (int key : keys) {
+            benchmark::DoNotOptimize(*container.lower_bound(key - 1));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/** @brief Erases every element by value in random order. */
+template <class Container>
+void BM_Erase(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    std::vector<int> order = keys;
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+    std::optional<Container> container;
+    for (auto _ : state) {
+        state.PauseTiming();
+        container.emplace();
+        Fill(*container, keys);
+        state.ResumeTiming();
+        for (int key : order) {
+            container->erase(key);
+        }
+        benchmark::DoNotOptimize(*container);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/** @brief Returns the iterator range of a traversal order. */
+template <class Container>
+auto Traversal(Container& container, Inorder) {
+    return std::make_pair(container.begin(), container.end());
+}
+
+template <class Container, class Pick>
+auto Traversal(Container& container, Pick) {
+    return std::make_pair(container.begin(Pick()), container.end(Pick()));
+}
+
+/** @brief Visits every element in the given traversal order. */
+template <class Container, class Pick>
+void BM_Traverse(benchmark::State& state) {
+    Container container;
+    Fill(container, MakeKeys(state.range(0), Random()));
+    for (auto _ : state) {
+        auto [it, end] = Traversal(container, Pick());
+        long long sum = 0;
+        for (; it != end; ++it) {
+            sum += *it;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/** @brief Visits every element through the stack-based for_each scan. */
+template <class Container>
+void BM_ForEach(benchmark::State& state) {
+    Container container;
+    Fill(container, MakeKeys(state.range(0), Random()));
+    for (auto _ : state) {
+        long long sum = 0;
+        container.for_each([&](int value) { sum += value; });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief Scans a pooled tree after erase churn has scattered its nodes:
+ * every key is erased and inserted again in random order, so live nodes
+ * land on recycled blocks. Compact runs compact() before scanning.
+ */
+template <bool Compact>
+void BM_ScanChurned(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    PoolBST container;
+    Fill(container, keys);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(7));
+    for (size_t i = 0; i < keys.size(); i += 1024) {
+        size_t last = std::min(keys.size(), i + 1024);
+        for (size_t j = i; j < last; ++j) {
+            container.erase(keys[j]);
+        }
+        for (size_t j = i; j < last; ++j) {
+            container.insert(keys[j]);
+        }
+    }
+    if (Compact) {
+        container.compact();
+    }
+    for (auto _ : state) {
+        long long sum = 0;
+        container.for_each([&](int value) { sum += value; });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/** @brief Sums the tree with parallel_reduce under a given policy. */
+template <class Policy>
+void BM_Reduce(benchmark::State& state) {
+    RedBlackBST container;
+    Fill(container, MakeKeys(state.range(0), Random()));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(container.parallel_reduce(
+            Policy(), 0LL, [](long long a, long long b) { return a + b; }));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief Ingests a batch of 100k unsorted keys into a populated tree, one
+ * element at a time or (Batch) through insert_batch().
+ */
+template <class Container, bool Batch>
+void BM_IngestBatch(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    Container base;
+    Fill(base, keys);
+    std::vector<int> batch = MakeKeys(100000, Random());
+    for (int& key : batch) {
+        key += 1;
+    }
+    std::optional<Container> container;
+    for (auto _ : state) {
+        state.PauseTiming();
+        container.emplace(base);
+        state.ResumeTiming();
+        if constexpr (Batch) {
+            container->insert_batch(batch);
+        } else {
+            container->insert(batch.begin(), batch.end());
+        }
+        benchmark::DoNotOptimize(*container);
+        state.PauseTiming();
+        container.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+
+/** @brief Splits a populated tree at a random key and joins it back. */
+template <class Container>
+void BM_SplitJoin(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    Container container;
+    Fill(container, keys);
+    size_t next = 0;
+    for (auto _ : state) {
+        auto [low, high] = container.split(keys[next++ % keys.size()]);
+        container = Container::join(std::move(low), std::move(high));
+        benchmark::DoNotOptimize(container);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/** @brief Deep-copies a populated container. */
+template <class Container>
+void BM_Copy(benchmark::State& state) {
+    Container container;
+    Fill(container, MakeKeys(state.range(0), Random()));
+    std::optional<Container> copy;
+    for (auto _ : state) {
+        copy.emplace(container);
+        benchmark::DoNotOptimize(*copy);
+        state.PauseTiming();
+        copy.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/** @brief Clears a populated container. */
+template <class Container>
+void BM_Clear(benchmark::State& state) {
+    std::vector<int> keys = MakeKeys(state.range(0), Random());
+    Container container;
+    for (auto _ : state) {
+        state.PauseTiming();
+        Fill(container, keys);
+        state.ResumeTiming();
+        container.clear();
+        benchmark::DoNotOptimize(container);
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/** @brief Red-black tree behind a single mutex, the baseline for ConcurrentBST. */
+class MutexBST {
+   private:
+    RedBlackBST tree_;
+    mutable std::mutex mutex_;
+
+   public:
+    void insert(int value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tree_.insert(value);
+    }
+
+    size_t erase(int value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tree_.erase(value);
+    }
+
+    bool contains(int value) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tree_.contains(value);
+    }
+};
+
+/** @brief Returns a tree of 1e5 keys shared by all benchmark threads. */
+template <class Container>
+Container& SharedTree() {
+    static Container container;
+    static bool filled = [] {
+        for (int key : MakeKeys(100000, Random())) {
+            container.insert(key);
+        }
+        if constexpr (requires { container.rebalance(); }) {
+            container.rebalance();
+        }
+        return true;
+    }();
+    (void)filled;
+    return container;
+}
+
+/** @brief 95% lookups and 5% updates from every thread on one shared tree. */
+template <class Container>
+void BM_ConcurrentMixed(benchmark::State& state) {
+    Container& container = SharedTree<Container>();
+    std::mt19937 rng(static_cast<unsigned>(state.thread_index()));
+    size_t op = 0;
+    for (auto _ : state) {
+        int key = static_cast<int>(rng() % 200000);
+        if (++op % 20 == 0) {
+            if (container.erase(key) == 0) {
+                container.insert(key);
+            }
+        } else {
+            benchmark::DoNotOptimize(container.contains(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/** @brief Every thread inserts and erases random keys on one shared tree. */
+template <class Container>
+void BM_ConcurrentIngest(benchmark::State& state) {
+    Container& container = SharedTree<Container>();
+    std::mt19937 rng(static_cast<unsigned>(state.thread_index()));
+    int pending = -1;
+    for (auto _ : state) {
+        if (pending < 0) {
+            pending = static_cast<int>(rng() % 200000);
+            container.insert(pending);
+        } else {
+            container.erase(pending);
+            pending = -1;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+#define BST_SIZES RangeMultiplier(10)->Range(1000, 10000000)
+
+// Sorted input degrades the unbalanced tree into a chain (O(n^2) build),
+// so those runs stop at 1e4 elements.
+#define BST_CHAIN_SIZES RangeMultiplier(10)->Range(1000, 10000)
+
+BENCHMARK_TEMPLATE(BM_Insert, UnbalancedBST, Random)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, UnbalancedBST, Sorted)->BST_CHAIN_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, UnbalancedBST, Reverse)->BST_CHAIN_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, RedBlackBST, Random)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, RedBlackBST, Sorted)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, RedBlackBST, Reverse)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, StdSet, Random)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, Persistent, Random)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, StdMultiset, Random)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, StdMultiset, Sorted)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, StdMultiset, Reverse)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, BTree, Random)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Insert, BTree, Sorted)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_Append, UnbalancedBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Append, RedBlackBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Append, StdMultiset)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_Find, UnbalancedBST, true)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, UnbalancedBST, false)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, RedBlackBST, true)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, RedBlackBST, false)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, StdSet, true)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, StdSet, false)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, StdMultiset, true)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, StdMultiset, false)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, Frozen, true)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, Frozen, false)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, Compact, true)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, BTree, true)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Find, BTree, false)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_FindClustered, RedBlackBST, false)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_FindClustered, RedBlackBST, true)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_FindBatch, RedBlackBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_FindBatch, Compact)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_FindBatch, Frozen)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_LowerBound, UnbalancedBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_LowerBound, RedBlackBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_LowerBound, StdMultiset)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_LowerBound, Frozen)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_LowerBound, BTree)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_Erase, UnbalancedBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Erase, RedBlackBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Erase, StdMultiset)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Erase, BTree)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_Traverse, UnbalancedBST, Inorder)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Traverse, UnbalancedBST, Preorder)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Traverse, UnbalancedBST, Postorder)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Traverse, RedBlackBST, Inorder)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Traverse, RedBlackBST, Preorder)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Traverse, RedBlackBST, Postorder)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Traverse, StdMultiset, Inorder)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Traverse, BTree, Inorder)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_ForEach, UnbalancedBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_ForEach, RedBlackBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_ScanChurned, false)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_ScanChurned, true)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_Reduce, Sequential)->BST_SIZES->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Reduce, Parallel)->BST_SIZES->UseRealTime();
+
+BENCHMARK_TEMPLATE(BM_IngestBatch, RedBlackBST, false)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_IngestBatch, RedBlackBST, true)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_SplitJoin, RedBlackBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_SplitJoin, OrderStatBST)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_Copy, UnbalancedBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Copy, RedBlackBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Copy, StdMultiset)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Copy, Persistent)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_Clear, UnbalancedBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Clear, RedBlackBST)->BST_SIZES;
+BENCHMARK_TEMPLATE(BM_Clear, StdMultiset)->BST_SIZES;
+
+BENCHMARK_TEMPLATE(BM_ConcurrentMixed, MutexBST)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentMixed, ConcurrentBST<int>)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentMixed, ShardedBST<int>)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentIngest, MutexBST)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ConcurrentIngest, ShardedBST<int>)->ThreadRange(1, 32)->UseRealTime();
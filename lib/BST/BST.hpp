@@ -1,6 +1,27 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <exception>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Compare.hpp"
+#include "FrozenBST.hpp"
+#include "Snapshot.hpp"
 
 using std::initializer_list;
 using std::pair;
@@ -20,6 +41,161 @@ struct Preorder {};
  */
 struct Postorder {};
 
+/**
+ * @brief Balancing policy tag: plain BST without any rebalancing.
+ */
+struct Unbalanced {
+    /** @brief Per-node balancing data (none). */
+    struct node_base {};
+};
+
+/**
+ * @brief Balancing policy tag: red-black tree keeping height O(log n).
+ */
+struct RedBlack {
+    /** @brief Per-node balancing data: the node colour. */
+    struct node_base {
+        bool red_ = false;
+    };
+};
+
+/**
+ * @brief Augmentation tag: no per-node bookkeeping.
+ */
+struct NoAugment {
+    /** @brief Per-node augmentation data (none). */
+    struct node_base {};
+};
+
+/**
+ * @brief Augmentation tag: subtree sizes enabling order statistics
+ * (nth, rank, count_range) in O(height).
+ */
+struct SubtreeSize {
+    /** @brief Per-node augmentation data: size of the subtree. */
+    struct node_base {
+        size_t subtree_size_ = 1;
+    };
+};
+
+/**
+ * @brief Execution policy tag: run on the calling thread.
+ */
+struct Sequential {};
+
+/**
+ * @brief Execution policy tag: spread the work over worker threads.
+ */
+struct Parallel {
+    /** @brief Number of threads; 0 picks std::thread::hardware_concurrency(). */
+    size_t threads_ = 0;
+};
+
+/**
+ * @brief Runs job(i) for every task index on a set of threads.
+ *
+ * Tasks are handed out dynamically in order. The first exception stops
+ * the handout and is rethrown once all threads have joined.
+ */
+template <class Job>
+void RunTasks(size_t count, size_t threads, Job job) {
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+    auto worker = [&] {
+        for (size_t i; !failed.load() && (i = next.fetch_add(1)) < count;) {
+            try {
+                job(i);
+            } catch (...) {
+                if (!failed.exchange(true)) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Resolves the thread count of a Parallel policy.
+ * @param items Amount of work; no more threads than items are used.
+ */
+inline size_t ThreadCount(Parallel policy, size_t items) {
+    size_t threads = policy.threads_ != 0
+                         ? policy.threads_
+                         : std::thread::hardware_concurrency();
+    return std::clamp<size_t>(threads, 1, std::max<size_t>(items, 1));
+}
+
+/**
+ * @brief Statistics policy tag: no instrumentation (the default).
+ */
+struct NoStats {};
+
+/**
+ * @brief Statistics policy tag: count operations, comparisons and shape
+ * on the hot paths. See TreeStats.
+ */
+struct CollectStats {};
+
+/**
+ * @brief Counters kept by a tree built with the CollectStats policy.
+ *
+ * Lookups are the lower-bound, upper-bound and find descents behind every
+ * search; one comparison is counted per level visited. Insert depths are
+ * measured when a leaf is linked, before rebalancing. Elements added by a
+ * bulk merge show up as rebuilds_ rather than inserts_.
+ */
+struct TreeStats {
+    size_t inserts_ = 0;        ///< Elements linked one at a time.
+    size_t erases_ = 0;         ///< Elements removed.
+    size_t lookups_ = 0;        ///< Search descents.
+    size_t comparisons_ = 0;    ///< Levels visited by the search descents.
+    size_t depth_sum_ = 0;      ///< Sum of the insert depths.
+    size_t max_depth_ = 0;      ///< Deepest insert seen (the root is depth 1).
+    size_t allocations_ = 0;    ///< Nodes allocated.
+    size_t deallocations_ = 0;  ///< Nodes released.
+    size_t rotations_ = 0;      ///< Rebalancing rotations.
+    size_t rebuilds_ = 0;       ///< Whole-tree rebuilds by bulk operations.
+
+    /** @brief Returns the mean comparisons per lookup (0 with no lookups). */
+    double comparisons_per_lookup() const {
+        return lookups_ != 0 ? static_cast<double>(comparisons_) / lookups_ : 0.0;
+    }
+
+    /** @brief Returns the mean insert depth (0 with no inserts). */
+    double average_depth() const {
+        return inserts_ != 0 ? static_cast<double>(depth_sum_) / inserts_ : 0.0;
+    }
+};
+
+/**
+ * @brief Heap memory of a tree, as reported by BST::memory_usage().
+ *
+ * Only arena allocators such as PoolAllocator expose what they reserve;
+ * for other allocators allocated_bytes_ equals node_bytes_.
+ */
+struct MemoryUsage {
+    size_t node_bytes_ = 0;       ///< Bytes of the live nodes.
+    size_t allocated_bytes_ = 0;  ///< Bytes the allocator holds for nodes.
+
+    /**
+     * @brief Returns the bytes held but not in live nodes: free blocks,
+     * block padding and unused chunk space.
+     */
+    size_t overhead_bytes() const { return allocated_bytes_ - node_bytes_; }
+};
+
 /**
  * @brief Compile-time conditional type selection.
  * @tparam B Boolean condition.
@@ -129,13 +305,20 @@ class ReverseIterator {
 /**
  * @brief Internal node structure for the Binary Search Tree.
  * @tparam T The type of data stored in the node.
+ * @tparam Bases Policy-provided per-node data (e.g. the red-black colour).
  */
-template <class T>
-struct Node {
-    T data_;
-    Node<T>* parent_;
-    Node<T>* left_;
-    Node<T>* right_;
+template <class T, class... Bases>
+struct Node : Bases... {
+    /** @brief Element storage; left unconstructed in the sentinel. */
+    union {
+        T data_;
+    };
+    Node* parent_ = nullptr;
+    Node* left_ = nullptr;
+    Node* right_ = nullptr;
+
+    Node() {}
+    ~Node() {}
 };
 
 /**
@@ -143,14 +326,30 @@ struct Node {
  * @tparam T Type of the elements.
  * @tparam Compare Comparison functor for ordering.
  * @tparam Alloc Allocator for memory management.
+ * @tparam Balance Balancing policy (Unbalanced or RedBlack).
+ * @tparam Augment Node augmentation (NoAugment or SubtreeSize).
+ * @tparam Stats Statistics policy (NoStats or CollectStats).
  */
 template <class T, class Compare = std::less<T>,
-          class Alloc = std::allocator<T>>
+          class Alloc = std::allocator<T>, class Balance = Unbalanced,
+          class Augment = NoAugment, class Stats = NoStats>
 class BST {
+    using tree_node = Node<T, typename Balance::node_base,
+                           typename Augment::node_base>;
+    static constexpr bool kSubtreeSize = std::is_same_v<Augment, SubtreeSize>;
+    /** @brief Whether the hot paths update the TreeStats counters. */
+    static constexpr bool kStats = std::is_same_v<Stats, CollectStats>;
+    /** @brief Elements staged per read or write by save() and load(). */
+    static constexpr size_t kSnapshotChunk = 4096;
+    /** @brief Fewest batch elements worth a thread of their own to sort. */
+    static constexpr size_t kSortSlice = 16384;
+    /** @brief Capacity of the ancestor stack used by full scans. */
+    static constexpr size_t kScanDepth = 128;
     using allocator_type = Alloc;
     using node_allocator_traits = std::allocator_traits<allocator_type>;
     using node_allocator_type =
-        typename node_allocator_traits::template rebind_alloc<Node<T>>;
+        typename node_allocator_traits::template rebind_alloc<tree_node>;
+    using node_traits = std::allocator_traits<node_allocator_type>;
 
    private:
     /**
@@ -161,28 +360,70 @@ class BST {
     template <bool IsConst, class Pick = Inorder>
     class Iterator {
         using conditional_ptr =
-            conditional_t<IsConst, const Node<T>*, Node<T>*>;
+            conditional_t<IsConst, const tree_node*, tree_node*>;
         using conditional_ref = conditional_t<IsConst, const T&, T&>;
-        friend class BST<T, Compare, Alloc>;
+        friend class BST;
 
        private:
         conditional_ptr it_;
 
+        // The sentinel is the only node without a parent; the tree hangs off
+        // its left child and its right child is always null. Every climb
+        // below therefore stops at the root or at the sentinel on its own.
+
+        /** @brief Descends to the leftmost node of a subtree. */
+        static conditional_ptr Leftmost(conditional_ptr node) {
+            while (node->left_ != nullptr) {
+                node = node->left_;
+            }
+            return node;
+        }
+
+        /** @brief Descends to the rightmost node of a subtree. */
+        static conditional_ptr Rightmost(conditional_ptr node) {
+            while (node->right_ != nullptr) {
+                node = node->right_;
+            }
+            return node;
+        }
+
+        /** @brief Descends to the first Post-order node of a subtree. */
+        static conditional_ptr FirstPostorder(conditional_ptr node) {
+            for (;;) {
+                if (node->left_ != nullptr) {
+                    node = node->left_;
+                } else if (node->right_ != nullptr) {
+                    node = node->right_;
+                } else {
+                    return node;
+                }
+            }
+        }
+
+        /** @brief Descends to the last Pre-order node of a subtree. */
+        static conditional_ptr LastPreorder(conditional_ptr node) {
+            for (;;) {
+                if (node->right_ != nullptr) {
+                    node = node->right_;
+                } else if (node->left_ != nullptr) {
+                    node = node->left_;
+                } else {
+                    return node;
+                }
+            }
+        }
+
         /** @brief Internal logic to advance iterator for In-order traversal. */
         Iterator& Add(Inorder) {
             if (it_->right_ != nullptr) {
-                it_ = it_->right_;
-                while (it_->left_ != nullptr) {
-                    it_ = it_->left_;
-                }
+                it_ = Leftmost(it_->right_);
             } else if (it_->parent_ != nullptr) {
-                while (it_ == it_->parent_->right_) {
-                    it_ = it_->parent_;
-                    if (it_->parent_->parent_ == nullptr) {
-                        break;
-                    }
+                conditional_ptr parent = it_->parent_;
+                while (it_ == parent->right_) {
+                    it_ = parent;
+                    parent = parent->parent_;
                 }
-                it_ = it_->parent_;
+                it_ = parent;
             }
             return *this;
         }
@@ -191,17 +432,16 @@ class BST {
         Iterator& Add(Preorder) {
             if (it_->left_ != nullptr) {
                 it_ = it_->left_;
+            } else if (it_->right_ != nullptr) {
+                it_ = it_->right_;
             } else {
-                while (it_->parent_ != nullptr &&
-                       (it_ == it_->parent_->right_ ||
-                        it_->parent_->right_ == nullptr)) {
-                    it_ = it_->parent_;
-                }
-                if (it_->parent_ != nullptr) {
-                    it_ = it_->parent_;
-                }
-                if (it_->right_ != nullptr) {
-                    it_ = it_->right_;
+                for (conditional_ptr parent = it_->parent_; parent != nullptr;
+                     parent = parent->parent_) {
+                    if (it_ == parent->left_ && parent->right_ != nullptr) {
+                        it_ = parent->right_;
+                        return *this;
+                    }
+                    it_ = parent;
                 }
             }
             return *this;
@@ -209,16 +449,14 @@ class BST {
 
         /** @brief Internal logic to advance iterator for Post-order traversal. */
         Iterator& Add(Postorder) {
-            if (it_ == it_->parent_->left_) {
-                it_ = it_->parent_;
-                if (it_->right_ != nullptr) {
-                    it_ = it_->right_;
-                    while (it_->left_ != nullptr) {
-                        it_ = it_->left_;
-                    }
-                }
+            conditional_ptr parent = it_->parent_;
+            if (parent == nullptr) {
+                return *this;
+            }
+            if (it_ == parent->left_ && parent->right_ != nullptr) {
+                it_ = FirstPostorder(parent->right_);
             } else {
-                it_ = it_->parent_;
+                it_ = parent;
             }
             return *this;
         }
@@ -226,16 +464,11 @@ class BST {
         /** @brief Internal logic to retreat iterator for In-order traversal. */
         Iterator& Subtract(Inorder) {
             if (it_->left_ != nullptr) {
-                it_ = it_->left_;
-                while (it_->right_ != nullptr) {
-                    it_ = it_->right_;
-                }
+                it_ = Rightmost(it_->left_);
             } else if (it_->parent_ != nullptr) {
-                while (it_ == it_->parent_->left_) {
+                // The root is a left child too, so stop below the sentinel.
+                while (it_->parent_->parent_ != nullptr && it_ == it_->parent_->left_) {
                     it_ = it_->parent_;
-                    if (it_->parent_->parent_ == nullptr) {
-                        break;
-                    }
                 }
                 it_ = it_->parent_;
             }
@@ -244,59 +477,57 @@ class BST {
 
         /** @brief Internal logic to retreat iterator for Pre-order traversal. */
         Iterator& Subtract(Preorder) {
-            if (it_->parent_ == nullptr) {
-                it_ = it_->left_;
-                while (it_->right_ != nullptr) {
-                    it_ = it_->right_;
-                }
-                return *this;
-            }
-            if (it_ == it_->parent_->left_) {
-                it_ = it_->parent_;
-            } else {
-                it_ = it_->parent_;
+            conditional_ptr parent = it_->parent_;
+            if (parent == nullptr) {
                 if (it_->left_ != nullptr) {
-                    it_ = it_->left_;
-                    while (it_->right_ != nullptr) {
-                        it_ = it_->right_;
-                    }
+                    it_ = LastPreorder(it_->left_);
                 }
+            } else if (it_ == parent->left_ || parent->left_ == nullptr) {
+                it_ = parent;
+            } else {
+                it_ = LastPreorder(parent->left_);
             }
             return *this;
         }
 
         /** @brief Internal logic to retreat iterator for Post-order traversal. */
         Iterator& Subtract(Postorder) {
-            if (it_->parent_ == nullptr) {
-                it_ = it_->left_;
-                return *this;
-            } else if (it_->right_ != nullptr) {
+            if (it_->right_ != nullptr) {
                 it_ = it_->right_;
             } else if (it_->left_ != nullptr) {
                 it_ = it_->left_;
             } else {
-                while (it_->parent_->right_ == nullptr ||
-                       it_ == it_->parent_->left_) {
-                    it_ = it_->parent_;
-                    if (it_->parent_ == nullptr) {
+                for (conditional_ptr parent = it_->parent_; parent != nullptr;
+                     parent = parent->parent_) {
+                    if (it_ == parent->right_ && parent->left_ != nullptr) {
+                        it_ = parent->left_;
                         return *this;
                     }
-                }
-                it_ = it_->parent_;
-                if (it_->left_ != nullptr) {
-                    it_ = it_->left_;
+                    it_ = parent;
                 }
             }
             return *this;
         }
 
        public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = conditional_t<IsConst, const T*, T*>;
+        using reference = conditional_ref;
+
+        /** @brief Default constructor creating a singular iterator. */
+        Iterator() : it_(nullptr) {}
+
         /** @brief Constructor initializing iterator with a node. */
         Iterator(conditional_ptr current) : it_(current) {}
 
         /** @brief Dereference operator to access node data. */
         conditional_ref operator*() const { return it_->data_; }
 
+        /** @brief Member access to node data. */
+        pointer operator->() const { return &it_->data_; }
+
         /** @brief Pre-increment operator. */
         Iterator& operator++() { return Add(Pick()); }
 
@@ -328,72 +559,323 @@ class BST {
         }
     };
 
-    Node<T>* root_;
-    size_t size_;
-    Compare comp_;
+    /**
+     * @brief Owning handle to a node detached from a tree.
+     *
+     * Returned by extract() and consumed by insert(), so an element changes
+     * trees, or is re-keyed through value(), without being reallocated or
+     * copied. An empty handle owns nothing; a non-empty one keeps a copy of
+     * the allocator and frees the node on destruction.
+     */
+    class NodeHandle {
+        friend class BST;
+
+       private:
+        tree_node* node_ = nullptr;
+        std::optional<node_allocator_type> alloc_;
+
+        NodeHandle(tree_node* node, const node_allocator_type& alloc)
+            : node_(node), alloc_(alloc) {}
+
+        /** @brief Destroys and frees the owned node, if any. */
+        void Reset() {
+            if (node_ != nullptr) {
+                node_traits::destroy(*alloc_, std::addressof(node_->data_));
+                node_->~tree_node();
+                node_traits::deallocate(*alloc_, node_, 1);
+                node_ = nullptr;
+            }
+            alloc_.reset();
+        }
+
+       public:
+        using value_type = T;
+        using allocator_type = Alloc;
+
+        /** @brief Creates an empty handle. */
+        NodeHandle() = default;
+
+        /** @brief Takes over the node of another handle, leaving it empty. */
+        NodeHandle(NodeHandle&& other) noexcept
+            : node_(std::exchange(other.node_, nullptr)),
+              alloc_(std::move(other.alloc_)) {
+            other.alloc_.reset();
+        }
+
+        /** @brief Frees the owned node, then takes over the other's. */
+        NodeHandle& operator=(NodeHandle&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                node_ = std::exchange(other.node_, nullptr);
+                alloc_ = std::move(other.alloc_);
+                other.alloc_.reset();
+            }
+            return *this;
+        }
+
+        /** @brief Destructor. Frees the owned node, if any. */
+        ~NodeHandle() { Reset(); }
+
+        /** @brief Checks whether the handle owns no node. */
+        bool empty() const { return node_ == nullptr; }
+
+        /** @brief Checks whether the handle owns a node. */
+        explicit operator bool() const { return node_ != nullptr; }
+
+        /** @brief Returns the element; the handle must not be empty. */
+        T& value() const { return node_->data_; }
+
+        /** @brief Returns the allocator; the handle must not be empty. */
+        allocator_type get_allocator() const { return allocator_type(*alloc_); }
+
+        /** @brief Swaps two handles. */
+        void swap(NodeHandle& other) noexcept {
+            std::swap(node_, other.node_);
+            std::swap(alloc_, other.alloc_);
+        }
+
+        /** @brief Swaps two handles. */
+        friend void swap(NodeHandle& lhs, NodeHandle& rhs) noexcept { lhs.swap(rhs); }
+    };
+
     node_allocator_type alloc_;
+    Compare comp_;
+    /** @brief Embedded sentinel; the tree hangs off its left child. */
+    tree_node header_;
+    tree_node* root_;
+    /** @brief The maximum node, or the sentinel when empty; O(1) appends. */
+    tree_node* rightmost_;
+    size_t size_;
+    /** @brief Counters owned by this object; empty unless kStats. */
+    [[no_unique_address]] mutable conditional_t<kStats, TreeStats, NoStats> stats_;
 
     /**
-     * @brief Internal helper to allocate and initialize a new node.
+     * @brief Internal helper to allocate a node with unlinked, empty storage.
      * @return Pointer to the newly allocated node.
      */
-    Node<T>* alloc_node() {
-        Node<T>* node = alloc_.allocate(1);
-        new (node) Node<T>();
+    tree_node* alloc_node() {
+        tree_node* node = node_traits::allocate(alloc_, 1);
+        new (node) tree_node();
+        if constexpr (kStats) {
+            ++stats_.allocations_;
+        }
+        return node;
+    }
+
+    /**
+     * @brief Internal helper to allocate a node and construct its value in place.
+     * @param args Arguments forwarded to the constructor of T.
+     * @return Pointer to the newly created node.
+     */
+    template <class... Args>
+    tree_node* create_node(Args&&... args) {
+        tree_node* node = alloc_node();
+        try {
+            node_traits::construct(alloc_, std::addressof(node->data_),
+                                   std::forward<Args>(args)...);
+        } catch (...) {
+            free_node(node);
+            throw;
+        }
         return node;
     }
 
+    /**
+     * @brief Internal helper to deallocate a node without a value.
+     * @param node_ Pointer to the node to be released.
+     */
+    void free_node(tree_node* node_) {
+        node_->~tree_node();
+        node_traits::deallocate(alloc_, node_, 1);
+        if constexpr (kStats) {
+            ++stats_.deallocations_;
+        }
+    }
+
     /**
      * @brief Internal helper to destroy and deallocate a node.
      * @param node_ Pointer to the node to be removed.
      */
-    void delete_node(Node<T>* node_) {
+    void delete_node(tree_node* node_) {
         if (!node_) {
             return;
         }
-        node_->~Node<T>();
-        alloc_.deallocate(node_, 1);
+        node_traits::destroy(alloc_, std::addressof(node_->data_));
+        free_node(node_);
     }
 
     /**
-     * @brief Recursively deletes all nodes in a subtree.
+     * @brief Drops every node at once through an arena allocator.
+     *
+     * Only possible when the allocator provides release(), no other
+     * allocator shares its arena and T needs no destructor call.
+     * @return True if all nodes were released.
+     */
+    bool ReleaseArena() {
+        if constexpr (std::is_trivially_destructible_v<T> &&
+                      requires(node_allocator_type& alloc) {
+                          { alloc.release() } -> std::same_as<bool>;
+                      }) {
+            if (!alloc_.release()) {
+                return false;
+            }
+            if constexpr (kStats) {
+                stats_.deallocations_ += size_;
+            }
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Takes over the nodes of another tree, leaving it empty.
+     *
+     * Only the sentinel links change hands, so this is O(1).
+     * @param other The tree to move the nodes from.
+     */
+    void StealNodes(BST& other) noexcept {
+        root_->left_ = other.root_->left_;
+        if (root_->left_ != nullptr) {
+            root_->left_->parent_ = root_;
+        }
+        rightmost_ = root_->left_ != nullptr ? other.rightmost_ : root_;
+        size_ = other.size_;
+        other.root_->left_ = nullptr;
+        other.rightmost_ = other.root_;
+        other.size_ = 0;
+    }
+
+    /**
+     * @brief Move assignment when the nodes can change owner: the allocator
+     * propagates or both allocators are equal.
+     */
+    void MoveAssign(BST& other, std::true_type) noexcept(
+        std::is_nothrow_move_assignable_v<Compare>) {
+        clear();
+        if constexpr (node_traits::propagate_on_container_move_assignment::value) {
+            alloc_ = std::move(other.alloc_);
+        }
+        comp_ = std::move(other.comp_);
+        StealNodes(other);
+    }
+
+    /**
+     * @brief Move assignment when the allocators may differ: nodes are only
+     * stolen from an equal allocator, otherwise elements are moved one by one
+     * into nodes of this allocator.
+     */
+    void MoveAssign(BST& other, std::false_type) {
+        if (alloc_ == other.alloc_) {
+            MoveAssign(other, std::true_type());
+            return;
+        }
+        clear();
+        comp_ = other.comp_;
+        tree_node* head = nullptr;
+        tree_node** tail = &head;
+        try {
+            for (auto it = other.begin(); it != other.end(); ++it) {
+                *tail = create_node(std::move(*it));
+                tail = &(*tail)->right_;
+            }
+        } catch (...) {
+            *tail = nullptr;
+            DeleteList(head);
+            throw;
+        }
+        *tail = nullptr;
+        Rebuild(head, other.size_);
+        other.clear();
+    }
+
+    /**
+     * @brief Deletes all nodes in a subtree without recursion.
+     *
+     * Left children are rotated up until the current node has none, so
+     * each node is freed after its left subtree with O(1) extra space.
      * @param node The root node of the subtree to clear.
      */
-    void ClearRecursive(Node<T>* node) {
-        if (node != nullptr) {
-            ClearRecursive(node->left_);
-            ClearRecursive(node->right_);
-            delete_node(node);
+    void ClearSubtree(tree_node* node) {
+        while (node != nullptr) {
+            if (node->left_ != nullptr) {
+                tree_node* left = node->left_;
+                node->left_ = left->right_;
+                left->right_ = node;
+                node = left;
+            } else {
+                tree_node* next = node->right_;
+                delete_node(node);
+                node = next;
+            }
         }
     }
 
     /**
-     * @brief Recursively deep-copies a subtree.
-     * @param other The source node to copy.
+     * @brief Clones a single node: value and policy data, no links.
+     * @param other The source node.
+     * @return Pointer to the new node.
+     */
+    tree_node* CloneNode(const tree_node* other) {
+        tree_node* node = create_node(other->data_);
+        static_cast<typename Balance::node_base&>(*node) = *other;
+        static_cast<typename Augment::node_base&>(*node) = *other;
+        return node;
+    }
+
+    /**
+     * @brief Deep-copies a subtree without recursion.
+     *
+     * Walks the source in pre-order through parent links, keeping the copy
+     * cursor in step, so stack use is constant whatever the tree shape.
+     * @param other The source subtree root.
      * @param parent The parent node to assign to the new copy.
      * @return Pointer to the cloned subtree root.
      */
-    Node<T>* CopyRecursive(const Node<T>* other, Node<T>* parent = nullptr) {
+    tree_node* CopySubtree(const tree_node* other, tree_node* parent) {
         if (other == nullptr) {
             return nullptr;
         }
-        Node<T>* node = alloc_node();
-        node->data_ = other->data_;
-        node->parent_ = parent;
-        node->left_ = CopyRecursive(other->left_, node);
-        node->right_ = CopyRecursive(other->right_, node);
-        return node;
+        tree_node* top = CloneNode(other);
+        top->parent_ = parent;
+        const tree_node* source = other;
+        tree_node* target = top;
+        try {
+            while (true) {
+                if (source->left_ != nullptr && target->left_ == nullptr) {
+                    target->left_ = CloneNode(source->left_);
+                    target->left_->parent_ = target;
+                    source = source->left_;
+                    target = target->left_;
+                } else if (source->right_ != nullptr &&
+                           target->right_ == nullptr) {
+                    target->right_ = CloneNode(source->right_);
+                    target->right_->parent_ = target;
+                    source = source->right_;
+                    target = target->right_;
+                } else if (source == other) {
+                    break;
+                } else {
+                    source = source->parent_;
+                    target = target->parent_;
+                }
+            }
+        } catch (...) {
+            ClearSubtree(top);
+            throw;
+        }
+        return top;
     }
 
     /**
      * @brief Locates the node with the minimum value in the tree.
      * @return Pointer to the leftmost node.
      */
-    Node<T>* Leftmost() const {
+    tree_node* Leftmost() const {
         if (root_->left_ == nullptr) {
             return root_;
         }
-        Node<T>* current = root_->left_;
+        tree_node* current = root_->left_;
         while (current->left_ != nullptr) {
             current = current->left_;
         }
@@ -405,7 +887,7 @@ class BST {
      * @param node Start node.
      * @return Pointer to the leftmost descendant.
      */
-    Node<T>* Leftmost(Node<T>* node) const {
+    tree_node* Leftmost(tree_node* node) const {
         while (node->left_ != nullptr) {
             node = node->left_;
         }
@@ -413,113 +895,1298 @@ class BST {
     }
 
     /**
-     * @brief Locates the node with the maximum value in the tree.
-     * @return Pointer to the rightmost node.
+     * @brief Recomputes the cached maximum after the tree was replaced
+     * wholesale (copy, rebuild).
      */
-    Node<T>* Rightmost() const {
-        Node<T>* current = root_->left_;
-        while (current->right_ != nullptr) {
-            current = current->right_;
+    void ResetRightmost() {
+        rightmost_ = root_;
+        for (tree_node* current = root_->left_; current != nullptr;
+             current = current->right_) {
+            rightmost_ = current;
         }
-        return current;
     }
 
     /**
-     * @brief Internal logic to remove a node and maintain BST properties.
-     * @param node Pointer to the node to delete.
+     * @brief Descends to the first node not less than the value.
+     * @return The node, or the sentinel if every element is less.
      */
-    void DeleteNode(Node<T>* node) {
-        if (node->left_ == nullptr && node->right_ == nullptr) {
-            if (node == node->parent_->left_) {
-                node->parent_->left_ = nullptr;
-            } else {
-                node->parent_->right_ = nullptr;
-            }
-        } else if (node->left_ == nullptr) {
-            if (node == node->parent_->left_) {
-                node->parent_->left_ = node->right_;
-                node->right_->parent_ = node->parent_;
-            } else {
-                node->parent_->right_ = node->right_;
-                node->right_->parent_ = node->parent_;
-            }
-        } else if (node->right_ == nullptr) {
-            if (node == node->parent_->left_) {
-                node->parent_->left_ = node->left_;
-                node->left_->parent_ = node->parent_;
-            } else {
-                node->parent_->right_ = node->left_;
-                node->left_->parent_ = node->parent_;
-            }
-        } else {
-            Node<T>* temp = Leftmost(node->right_);
-            if (node == node->parent_->left_) {
-                node->parent_->left_ = node->right_;
-                node->right_->parent_ = node->parent_;
-            } else {
-                node->parent_->right_ = node->right_;
-                node->right_->parent_ = node->parent_;
-            }
-            temp->left_ = node->left_;
-            node->left_->parent_ = temp;
-        }
-        delete_node(node);
+    template <class K>
+    tree_node* LowerBoundNode(const K& value) const {
+        return LowerBoundFrom(root_->left_, root_, value);
     }
 
-   public:
     /**
-     * @brief Default constructor. Initializes an empty tree with a sentinel root.
+     * @brief Lower-bound descent within a subtree.
+     * @param current The subtree root (may be nullptr).
+     * @param result Returned if no node of the subtree is not less.
      */
-    BST() : root_(alloc_node()), size_(0), comp_(Compare()), alloc_(Alloc()) {}
+    template <class K>
+    tree_node* LowerBoundFrom(tree_node* current, tree_node* result,
+                              const K& value) const {
+        size_t steps = 0;
+        for (; current != nullptr; ++steps) {
+            bool right = Less(current->data_, value);
+            result = right ? result : current;
+            current = Child(current, right);
+        }
+        CountLookup(steps);
+        return result;
+    }
 
-    /**
-     * @brief Copy constructor. Performs a deep copy of another tree.
-     * @param other The tree to copy.
-     */
-    BST(const BST& other)
-        : root_(CopyRecursive(other.root_)),
-          size_(other.size_),
-          comp_(Compare()),
-          alloc_(Alloc()) {}
+    /** @brief Hints the cache that a (possibly null) node is read next. */
+    static void Prefetch(const tree_node* node) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(node);
+#else
+        (void)node;
+#endif
+    }
+
+    /** @brief Orders two keys through KeyLess(). */
+    template <class A, class B>
+    bool Less(const A& value, const B& key) const {
+        return KeyLess<T>(comp_, value, key);
+    }
 
     /**
-     * @brief Copy assignment operator.
-     * @param other The source tree.
-     * @return Reference to this tree.
+     * @brief Returns the right child if asked to, else the left one. For
+     * arithmetic keys under std::less the pick is an indexed load, so a
+     * descent on random keys pays no mispredicted branch per level.
      */
-    BST& operator=(const BST& other) {
-        if (this != &other) {
-            ClearRecursive(root_);
-            root_ = CopyRecursive(other.root_);
-            size_ = other.size_;
+    static tree_node* Child(const tree_node* node, bool right) {
+        if constexpr (kArithmeticLess<T, Compare>) {
+            tree_node* children[2] = {node->left_, node->right_};
+            return children[right];
+        } else {
+            return right ? node->right_ : node->left_;
         }
-        return *this;
     }
 
     /**
-     * @brief Move assignment operator.
-     * @param other Rvalue reference to the source tree.
-     * @return Reference to this tree.
+     * @brief Runs lower-bound descents for a batch of keys side by side.
+     *
+     * Up to kBatchLanes descents advance one level per round, so the cache
+     * misses of different keys overlap instead of being paid one after
+     * another. For arithmetic keys under std::less each step is a plain
+     * comparison and conditional moves.
+     * @param keys The keys to look up.
+     * @param emit Called as emit(i, node) with the lower bound of keys[i].
      */
-    BST& operator=(BST&& other) {
-        if (this != &other) {
-            ClearRecursive(root_);
-            root_ = other.root_;
-            size_ = other.size_;
+    template <class Emit>
+    void LowerBoundBatch(std::span<const T> keys, Emit emit) const {
+        for (size_t base = 0; base < keys.size(); base += kBatchLanes) {
+            size_t lanes = std::min(kBatchLanes, keys.size() - base);
+            const T* key = keys.data() + base;
+            tree_node* current[kBatchLanes];
+            tree_node* result[kBatchLanes];
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                current[lane] = root_->left_;
+                result[lane] = root_;
+            }
+            for (bool active = root_->left_ != nullptr; active;) {
+                active = false;
+                for (size_t lane = 0; lane < lanes; ++lane) {
+                    tree_node* node = current[lane];
+                    if (node == nullptr) {
+                        continue;
+                    }
+                    if constexpr (kStats) {
+                        ++stats_.comparisons_;
+                    }
+                    bool right = Less(node->data_, key[lane]);
+                    result[lane] = right ? result[lane] : node;
+                    current[lane] = right ? node->right_ : node->left_;
+                    Prefetch(current[lane]);
+                    active |= current[lane] != nullptr;
+                }
+            }
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                emit(base + lane, result[lane]);
+            }
+        }
+        if constexpr (kStats) {
+            stats_.lookups_ += keys.size();
         }
-        return *this;
     }
 
     /**
-     * @brief Constructor that initializes the tree from a list of values.
-     * @param ilist Initializer list of elements.
+     * @brief Batched FindNode: the first node equal to each key.
+     * @param emit Called as emit(i, node), node being the sentinel on a miss.
      */
-    BST(initializer_list<T> ilist) : BST() {
-        insert(ilist.begin(), ilist.end());
+    template <class Emit>
+    void FindBatch(std::span<const T> keys, Emit emit) const {
+        LowerBoundBatch(keys, [&](size_t i, tree_node* node) {
+            if (node != root_ && comp_(keys[i], node->data_)) {
+                node = root_;
+            }
+            emit(i, node);
+        });
     }
 
     /**
-     * @brief Replaces contents with values from an initializer list.
+     * @brief Descends to the first node greater than the value.
+     * @return The node, or the sentinel if no element is greater.
+     */
+    template <class K>
+    tree_node* UpperBoundNode(const K& value, Inorder = Inorder()) const {
+        tree_node* result = root_;
+        tree_node* current = root_->left_;
+        size_t steps = 0;
+        for (; current != nullptr; ++steps) {
+            bool left = Less(value, current->data_);
+            result = left ? current : result;
+            current = Child(current, !left);
+        }
+        CountLookup(steps);
+        return result;
+    }
+
+    /**
+     * @brief Upper bound for non-sorted traversals: the successor of the
+     * last equal element in that order, or the In-order bound if absent.
+     */
+    template <class K, class Pick>
+    tree_node* UpperBoundNode(const K& value, Pick) const {
+        tree_node* last = RFindNode(value);
+        if (last == root_) {
+            return UpperBoundNode(value);
+        }
+        return (++Iterator<false, Pick>(last)).it_;
+    }
+
+    /**
+     * @brief Locates the In-order run of nodes in [low, high); the end is
+     * found by finger search from the start.
+     * @return The bounds, both the same node when the run is empty.
+     */
+    template <class K>
+    pair<tree_node*, tree_node*> RangeOf(const K& low, const K& high) const {
+        tree_node* first = LowerBoundNode(low);
+        if (first == root_ || !comp_(low, high)) {
+            return {first, first};
+        }
+        auto [subtree, fallback] = FingerSubtree<false>(first, high);
+        return {first, LowerBoundFrom(subtree, fallback, high)};
+    }
+
+    /**
+     * @brief Descends to the first node equal to the value.
+     * @return The node, or the sentinel if the value is absent.
+     */
+    template <class K>
+    tree_node* FindNode(const K& value) const {
+        tree_node* node = LowerBoundNode(value);
+        if (node != root_ && comp_(value, node->data_)) {
+            return root_;
+        }
+        return node;
+    }
+
+    /**
+     * @brief Descends to the last node equal to the value.
+     * @return The node, or the sentinel if the value is absent.
+     */
+    template <class K>
+    tree_node* RFindNode(const K& value) const {
+        tree_node* result = root_;
+        tree_node* current = root_->left_;
+        size_t steps = 0;
+        for (; current != nullptr; ++steps) {
+            bool left = Less(value, current->data_);
+            result = left ? result : current;
+            current = Child(current, !left);
+        }
+        CountLookup(steps);
+        if (result != root_ && comp_(result->data_, value)) {
+            return root_;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Counts the elements less than (or, if inclusive, not greater
+     * than) a key by summing left-subtree sizes along one descent.
+     */
+    template <class K>
+    size_t Rank(const K& key, bool inclusive) const {
+        size_t rank = 0;
+        tree_node* current = root_->left_;
+        while (current != nullptr) {
+            bool before = inclusive ? !Less(key, current->data_)
+                                    : Less(current->data_, key);
+            rank += before ? SizeOf(current->left_) + 1 : 0;
+            current = Child(current, before);
+        }
+        return rank;
+    }
+
+    /** @brief Counts elements equivalent to a key. */
+    template <class K>
+    size_t CountEqual(const K& key) const {
+        if constexpr (kSubtreeSize) {
+            return Rank(key, true) - Rank(key, false);
+        } else {
+            size_t count = 0;
+            for (auto it = Iterator<true, Inorder>(LowerBoundNode(key));
+                 it != cend() && !comp_(key, *it); ++it) {
+                count++;
+            }
+            return count;
+        }
+    }
+
+    /**
+     * @brief Descends to the node at a given in-order index.
+     * @return The node, or the sentinel if k >= size().
+     */
+    tree_node* NthNode(size_t k) const {
+        static_assert(kSubtreeSize, "nth() requires the SubtreeSize augmentation");
+        if (k >= size_) {
+            return root_;
+        }
+        tree_node* current = root_->left_;
+        while (true) {
+            size_t left = SizeOf(current->left_);
+            if (k < left) {
+                current = current->left_;
+            } else if (k == left) {
+                return current;
+            } else {
+                k -= left + 1;
+                current = current->right_;
+            }
+        }
+    }
+
+    /**
+     * @brief Replaces the subtree rooted at one node with another subtree.
+     * @param node The node being replaced in its parent.
+     * @param child The replacement subtree root (may be nullptr).
+     */
+    void Transplant(tree_node* node, tree_node* child) {
+        if (node == node->parent_->left_) {
+            node->parent_->left_ = child;
+        } else {
+            node->parent_->right_ = child;
+        }
+        if (child != nullptr) {
+            child->parent_ = node->parent_;
+        }
+    }
+
+    /** @brief Returns the size of a (possibly null) subtree. */
+    static size_t SizeOf(const tree_node* node) {
+        return node != nullptr ? node->subtree_size_ : 0;
+    }
+
+    /** @brief Recomputes a node's subtree size from its children. */
+    static void Recount(tree_node* node) {
+        if constexpr (kSubtreeSize) {
+            node->subtree_size_ = 1 + SizeOf(node->left_) + SizeOf(node->right_);
+        }
+    }
+
+    /** @brief Recomputes subtree sizes from a node up to the tree root. */
+    void RecountPath(tree_node* node) {
+        if constexpr (kSubtreeSize) {
+            for (; node != root_; node = node->parent_) {
+                Recount(node);
+            }
+        }
+    }
+
+    /**
+     * @brief Rotates the subtree rooted at a node to the left.
+     * @param node The subtree root; its right child takes its place.
+     */
+    void RotateLeft(tree_node* node) {
+        tree_node* pivot = node->right_;
+        node->right_ = pivot->left_;
+        if (pivot->left_ != nullptr) {
+            pivot->left_->parent_ = node;
+        }
+        Transplant(node, pivot);
+        pivot->left_ = node;
+        node->parent_ = pivot;
+        Recount(node);
+        Recount(pivot);
+        if constexpr (kStats) {
+            ++stats_.rotations_;
+        }
+    }
+
+    /**
+     * @brief Rotates the subtree rooted at a node to the right.
+     * @param node The subtree root; its left child takes its place.
+     */
+    void RotateRight(tree_node* node) {
+        tree_node* pivot = node->left_;
+        node->left_ = pivot->right_;
+        if (pivot->right_ != nullptr) {
+            pivot->right_->parent_ = node;
+        }
+        Transplant(node, pivot);
+        pivot->right_ = node;
+        node->parent_ = pivot;
+        Recount(node);
+        Recount(pivot);
+        if constexpr (kStats) {
+            ++stats_.rotations_;
+        }
+    }
+
+    /** @brief Checks whether a (possibly null) node is red. */
+    static bool IsRed(const tree_node* node) {
+        return node != nullptr && node->red_;
+    }
+
+    /** @brief Rebalancing after insertion for the Unbalanced policy (no-op). */
+    void InsertFixup(tree_node*, Unbalanced) {}
+
+    /**
+     * @brief Restores red-black properties after linking a new leaf.
+     * @param node The freshly linked node.
+     * @return Whether the black height grew: the root was repainted black.
+     */
+    bool InsertFixup(tree_node* node, RedBlack) {
+        node->red_ = true;
+        // The sentinel is always black, so a red parent is never the root.
+        while (node->parent_->red_) {
+            tree_node* parent = node->parent_;
+            tree_node* grand = parent->parent_;
+            if (parent == grand->left_) {
+                tree_node* uncle = grand->right_;
+                if (IsRed(uncle)) {
+                    parent->red_ = false;
+                    uncle->red_ = false;
+                    grand->red_ = true;
+                    node = grand;
+                } else {
+                    if (node == parent->right_) {
+                        node = parent;
+                        RotateLeft(node);
+                        parent = node->parent_;
+                    }
+                    parent->red_ = false;
+                    grand->red_ = true;
+                    RotateRight(grand);
+                }
+            } else {
+                tree_node* uncle = grand->left_;
+                if (IsRed(uncle)) {
+                    parent->red_ = false;
+                    uncle->red_ = false;
+                    grand->red_ = true;
+                    node = grand;
+                } else {
+                    if (node == parent->left_) {
+                        node = parent;
+                        RotateRight(node);
+                        parent = node->parent_;
+                    }
+                    parent->red_ = false;
+                    grand->red_ = true;
+                    RotateLeft(grand);
+                }
+            }
+        }
+        bool grew = root_->left_->red_;
+        root_->left_->red_ = false;
+        return grew;
+    }
+
+    /** @brief Rebalancing after removal for the Unbalanced policy (no-op). */
+    void EraseFixup(tree_node*, tree_node*, bool, Unbalanced) {}
+
+    /**
+     * @brief Restores red-black properties after unlinking a node.
+     * @param node The node that took the removed position (may be nullptr).
+     * @param parent Parent of that position.
+     * @param removed_red Colour of the node physically removed.
+     */
+    void EraseFixup(tree_node* node, tree_node* parent, bool removed_red,
+                    RedBlack) {
+        if (removed_red) {
+            return;
+        }
+        while (node != root_->left_ && !IsRed(node)) {
+            if (node == parent->left_) {
+                tree_node* sibling = parent->right_;
+                if (sibling->red_) {
+                    sibling->red_ = false;
+                    parent->red_ = true;
+                    RotateLeft(parent);
+                    sibling = parent->right_;
+                }
+                if (!IsRed(sibling->left_) && !IsRed(sibling->right_)) {
+                    sibling->red_ = true;
+                    node = parent;
+                    parent = parent->parent_;
+                } else {
+                    if (!IsRed(sibling->right_)) {
+                        sibling->left_->red_ = false;
+                        sibling->red_ = true;
+                        RotateRight(sibling);
+                        sibling = parent->right_;
+                    }
+                    sibling->red_ = parent->red_;
+                    parent->red_ = false;
+                    sibling->right_->red_ = false;
+                    RotateLeft(parent);
+                    break;
+                }
+            } else {
+                tree_node* sibling = parent->left_;
+                if (sibling->red_) {
+                    sibling->red_ = false;
+                    parent->red_ = true;
+                    RotateRight(parent);
+                    sibling = parent->left_;
+                }
+                if (!IsRed(sibling->left_) && !IsRed(sibling->right_)) {
+                    sibling->red_ = true;
+                    node = parent;
+                    parent = parent->parent_;
+                } else {
+                    if (!IsRed(sibling->left_)) {
+                        sibling->right_->red_ = false;
+                        sibling->red_ = true;
+                        RotateLeft(sibling);
+                        sibling = parent->left_;
+                    }
+                    sibling->red_ = parent->red_;
+                    parent->red_ = false;
+                    sibling->left_->red_ = false;
+                    RotateRight(parent);
+                    break;
+                }
+            }
+        }
+        if (node != nullptr) {
+            node->red_ = false;
+        }
+    }
+
+    /** @brief Records one search descent that visited the given levels. */
+    void CountLookup(size_t steps) const {
+        if constexpr (kStats) {
+            ++stats_.lookups_;
+            stats_.comparisons_ += steps;
+        }
+    }
+
+    /** @brief Records a freshly linked leaf and its depth. */
+    void CountInsert(const tree_node* node) {
+        if constexpr (kStats) {
+            size_t depth = 0;
+            for (; node != root_; node = node->parent_) {
+                ++depth;
+            }
+            ++stats_.inserts_;
+            stats_.depth_sum_ += depth;
+            stats_.max_depth_ = std::max(stats_.max_depth_, depth);
+        }
+    }
+
+    /** @brief Returns the colour of a node, or false if the policy has none. */
+    static bool RemovedRed(const tree_node* node) {
+        if constexpr (std::is_same_v<Balance, RedBlack>) {
+            return node->red_;
+        } else {
+            return false;
+        }
+    }
+
+    /**
+     * @brief Links a fresh leaf under a parent and rebalances.
+     * @param parent The parent node (the sentinel for an empty tree).
+     * @param node The new leaf.
+     * @param left Whether to link as the left child.
+     */
+    void LinkNode(tree_node* parent, tree_node* node, bool left) {
+        if (parent == rightmost_ && (!left || parent == root_)) {
+            rightmost_ = node;
+        }
+        node->parent_ = parent;
+        node->left_ = nullptr;
+        node->right_ = nullptr;
+        if (left) {
+            parent->left_ = node;
+        } else {
+            parent->right_ = node;
+        }
+        RecountPath(node);
+        CountInsert(node);
+        InsertFixup(node, Balance());
+        size_++;
+    }
+
+    /**
+     * @brief Links a created node at its upper-bound position.
+     * @param node The node holding the new value.
+     * @return The linked node.
+     */
+    tree_node* InsertNode(tree_node* node) {
+        return InsertNodeFrom(root_->left_, node);
+    }
+
+    /**
+     * @brief Links a created node at its upper-bound position within a
+     * subtree that is known to contain that position.
+     * @param current The subtree root (nullptr only for an empty tree).
+     * @param node The node holding the new value.
+     * @return The linked node.
+     */
+    tree_node* InsertNodeFrom(tree_node* current, tree_node* node) {
+        tree_node* parent = root_;
+        bool left = true;
+        while (current != nullptr) {
+            parent = current;
+            left = Less(node->data_, current->data_);
+            current = left ? current->left_ : current->right_;
+        }
+        LinkNode(parent, node, left);
+        return node;
+    }
+
+    /**
+     * @brief Tells whether a key's bound lies after a node: past the last
+     * not-greater node for the upper bound, past the last less one otherwise.
+     */
+    template <bool Upper, class K>
+    bool BoundAfter(const tree_node* node, const K& key) const {
+        if constexpr (Upper) {
+            return !comp_(key, node->data_);
+        } else {
+            return comp_(node->data_, key);
+        }
+    }
+
+    /**
+     * @brief Climbs from a finger to the smallest subtree that holds the
+     * bound of a key.
+     *
+     * The walk up through parent_ stops at the first ancestor on the far
+     * side of the key, so a key d positions from the finger costs O(log d)
+     * comparisons in a balanced tree instead of a descent from the root.
+     * @tparam Upper Whether to locate the upper (insert) or lower bound.
+     * @param finger A node of the tree, not the sentinel.
+     * @return The subtree root, and the node to fall back on when the bound
+     * lies just past the subtree (the sentinel if none).
+     */
+    template <bool Upper, class K>
+    pair<tree_node*, tree_node*> FingerSubtree(tree_node* finger,
+                                               const K& key) const {
+        bool after = BoundAfter<Upper>(finger, key);
+        tree_node* node = finger;
+        for (tree_node* parent = node->parent_; parent != root_;
+             node = parent, parent = parent->parent_) {
+            // Only an ancestor reached from the finger's side can bound it.
+            if ((node == parent->left_) == after &&
+                BoundAfter<Upper>(parent, key) != after) {
+                return {node, after ? parent : root_};
+            }
+        }
+        return {node, root_};
+    }
+
+    /**
+     * @brief Finds the first node equal to a key, searching from a finger.
+     * @param finger Any node, or the sentinel to start from the maximum.
+     * @return The node, or the sentinel if the key is absent.
+     */
+    template <class K>
+    tree_node* FingerFind(tree_node* finger, const K& value) const {
+        if (finger == root_) {
+            finger = rightmost_;
+        }
+        if (finger == root_) {
+            return root_;
+        }
+        auto [subtree, fallback] = FingerSubtree<false>(finger, value);
+        tree_node* node = LowerBoundFrom(subtree, fallback, value);
+        if (node != root_ && comp_(value, node->data_)) {
+            return root_;
+        }
+        return node;
+    }
+
+    /**
+     * @brief Locates the in-order predecessor of a node.
+     * @return The predecessor, or the sentinel if there is none.
+     */
+    tree_node* Predecessor(tree_node* node) const {
+        if (node->left_ != nullptr) {
+            node = node->left_;
+            while (node->right_ != nullptr) {
+                node = node->right_;
+            }
+            return node;
+        }
+        tree_node* parent = node->parent_;
+        while (parent != nullptr && node == parent->left_) {
+            node = parent;
+            parent = parent->parent_;
+        }
+        return parent != nullptr ? parent : root_;
+    }
+
+    /**
+     * @brief Links a created node right before a position if that keeps
+     * the order, without descending from the root.
+     * @param pos The node the new one should precede (the sentinel for end).
+     * @param node The node holding the new value.
+     * @return The linked node.
+     */
+    tree_node* InsertNodeHint(tree_node* pos, tree_node* node) {
+        tree_node* prev = pos != root_ ? Predecessor(pos) : rightmost_;
+        if ((pos != root_ && comp_(pos->data_, node->data_)) ||
+            (prev != root_ && comp_(node->data_, prev->data_))) {
+            tree_node* finger = pos != root_ ? pos : prev;
+            return InsertNodeFrom(FingerSubtree<true>(finger, node->data_).first,
+                                  node);
+        }
+        if (pos->left_ == nullptr) {
+            LinkNode(pos, node, true);
+        } else {
+            LinkNode(prev, node, false);
+        }
+        return node;
+    }
+
+    /**
+     * @brief Turns a subtree into an in-order list linked through right_.
+     *
+     * Uses right rotations only (tree-to-vine), so it runs in O(n) without
+     * extra memory. Parent links of the listed nodes are left stale.
+     * @param node The subtree root (may be nullptr).
+     * @return Head of the list.
+     */
+    static tree_node* Flatten(tree_node* node) {
+        tree_node* head = node;
+        tree_node** link = &head;
+        while (node != nullptr) {
+            if (node->left_ == nullptr) {
+                link = &node->right_;
+                node = node->right_;
+            } else {
+                tree_node* left = node->left_;
+                node->left_ = left->right_;
+                left->right_ = node;
+                node = left;
+                *link = left;
+            }
+        }
+        return head;
+    }
+
+    /**
+     * @brief Stable merge of two sorted node lists linked through right_.
+     * @return Head of the merged list; equal nodes of the first list go first.
+     */
+    tree_node* MergeLists(tree_node* first, tree_node* second) const {
+        tree_node* head = nullptr;
+        tree_node** tail = &head;
+        while (first != nullptr && second != nullptr) {
+            if (comp_(second->data_, first->data_)) {
+                *tail = second;
+                second = second->right_;
+            } else {
+                *tail = first;
+                first = first->right_;
+            }
+            tail = &(*tail)->right_;
+        }
+        *tail = first != nullptr ? first : second;
+        return head;
+    }
+
+    /** @brief Returns the length of a list linked through right_. */
+    static size_t ListLength(const tree_node* head) {
+        size_t length = 0;
+        for (; head != nullptr; head = head->right_) {
+            ++length;
+        }
+        return length;
+    }
+
+    /** @brief Destroys every node of a list linked through right_. */
+    void DeleteList(tree_node* head) {
+        while (head != nullptr) {
+            tree_node* next = head->right_;
+            delete_node(head);
+            head = next;
+        }
+    }
+
+    /**
+     * @brief Recursively links the first n list nodes into a balanced subtree.
+     * @param list Current list head; advanced past the consumed nodes.
+     * @param n Number of nodes to take.
+     * @param depth Depth of the subtree root.
+     * @param red_depth Depth whose nodes are coloured red (the partial level).
+     * @return The subtree root.
+     */
+    tree_node* BuildBalanced(tree_node*& list, size_t n, size_t depth,
+                             size_t red_depth) {
+        if (n == 0) {
+            return nullptr;
+        }
+        tree_node* left = BuildBalanced(list, n / 2, depth + 1, red_depth);
+        tree_node* node = list;
+        list = list->right_;
+        node->left_ = left;
+        if (left != nullptr) {
+            left->parent_ = node;
+        }
+        node->right_ = BuildBalanced(list, n - n / 2 - 1, depth + 1, red_depth);
+        if (node->right_ != nullptr) {
+            node->right_->parent_ = node;
+        }
+        if constexpr (std::is_same_v<Balance, RedBlack>) {
+            node->red_ = depth == red_depth;
+        }
+        Recount(node);
+        return node;
+    }
+
+    /**
+     * @brief Replaces the contents with a balanced tree built from a list.
+     * @param head Sorted node list linked through right_.
+     * @param n Length of the list.
+     */
+    void Rebuild(tree_node* head, size_t n) {
+        // Levels above the partial bottom level are full, so painting only
+        // that level red keeps every root-to-leaf path equally black.
+        root_->left_ = BuildBalanced(head, n, 0, std::bit_width(n + 1) - 1);
+        if (root_->left_ != nullptr) {
+            root_->left_->parent_ = root_;
+        }
+        ResetRightmost();
+        size_ = n;
+        if constexpr (kStats) {
+            ++stats_.rebuilds_;
+        }
+    }
+
+    /**
+     * @brief Merges a sorted node list into the tree.
+     *
+     * Lists shorter than the tree are linked node by node, each found by
+     * finger search from the previous one, which costs O(k log(n/k)) for k
+     * nodes. Otherwise the tree is flattened, merged with the list and
+     * rebuilt, which is linear in the total size.
+     * @param head Sorted node list linked through right_.
+     * @param count Length of the list.
+     */
+    void MergeNodes(tree_node* head, size_t count) {
+        if (count < size_) {
+            // Each node belongs at or after the previous one: search from it.
+            tree_node* finger = nullptr;
+            while (head != nullptr) {
+                tree_node* next = head->right_;
+                finger = finger == nullptr
+                             ? InsertNode(head)
+                             : InsertNodeFrom(
+                                   FingerSubtree<true>(finger, head->data_).first,
+                                   head);
+                head = next;
+            }
+            return;
+        }
+        Rebuild(MergeLists(Flatten(root_->left_), head), size_ + count);
+    }
+
+    /**
+     * @brief Copies a sorted range into a fresh node list.
+     * @param first Beginning of the range.
+     * @param last End of the range.
+     * @param count Incremented by the number of created nodes.
+     * @return Head of the list linked through right_.
+     */
+    template <class InputIt>
+    tree_node* CreateList(InputIt first, InputIt last, size_t& count) {
+        tree_node* head = nullptr;
+        tree_node** tail = &head;
+        try {
+            for (; first != last; ++first) {
+                *tail = create_node(*first);
+                tail = &(*tail)->right_;
+                ++count;
+            }
+        } catch (...) {
+            *tail = nullptr;
+            DeleteList(head);
+            throw;
+        }
+        *tail = nullptr;
+        return head;
+    }
+
+    /**
+     * @brief Detaches a node from the tree and rebalances, without freeing it.
+     * @param node Pointer to the node to unlink.
+     */
+    void UnlinkNode(tree_node* node) {
+        if (node == rightmost_) {
+            rightmost_ = Predecessor(node);
+        }
+        tree_node* child;
+        tree_node* parent;
+        bool removed_red = RemovedRed(node);
+        if (node->left_ == nullptr || node->right_ == nullptr) {
+            child = node->left_ != nullptr ? node->left_ : node->right_;
+            parent = node->parent_;
+            Transplant(node, child);
+        } else {
+            tree_node* next = Leftmost(node->right_);
+            removed_red = RemovedRed(next);
+            child = next->right_;
+            if (next->parent_ == node) {
+                parent = next;
+            } else {
+                parent = next->parent_;
+                Transplant(next, child);
+                next->right_ = node->right_;
+                next->right_->parent_ = next;
+            }
+            Transplant(node, next);
+            next->left_ = node->left_;
+            next->left_->parent_ = next;
+            static_cast<typename Balance::node_base&>(*next) = *node;
+        }
+        RecountPath(parent);
+        EraseFixup(child, parent, removed_red, Balance());
+        if constexpr (kStats) {
+            ++stats_.erases_;
+        }
+    }
+
+    /**
+     * @brief Unlinks a node into a handle that owns it.
+     * @param node The node, or the sentinel for an empty handle.
+     */
+    NodeHandle ExtractNode(tree_node* node) {
+        if (node == root_) {
+            return NodeHandle();
+        }
+        UnlinkNode(node);
+        --size_;
+        return NodeHandle(node, alloc_);
+    }
+
+    /**
+     * @brief Takes the node out of a non-empty handle for linking, moving
+     * its value into a fresh node if the allocators differ.
+     */
+    tree_node* AdoptNode(NodeHandle& handle) {
+        if (*handle.alloc_ == alloc_) {
+            handle.alloc_.reset();
+            return std::exchange(handle.node_, nullptr);
+        }
+        tree_node* node = create_node(std::move(handle.node_->data_));
+        handle.Reset();
+        return node;
+    }
+
+    /**
+     * @brief Internal logic to remove a node and maintain BST properties.
+     * @param node Pointer to the node to delete.
+     */
+    void DeleteNode(tree_node* node) {
+        UnlinkNode(node);
+        delete_node(node);
+    }
+
+    /**
+     * @brief Removes the In-order run of nodes [first, last).
+     *
+     * Short runs are unlinked one by one; once the run is long enough that
+     * k rebalancing deletions cost more than a linear pass, the tree is
+     * flattened, the run is cut out of the list and the rest is rebuilt.
+     * Surviving nodes keep their identity, so iterators to them stay valid.
+     * @param first First node to remove.
+     * @param last Node after the run (the sentinel for the end).
+     * @return The number of removed nodes.
+     */
+    size_t EraseNodes(tree_node* first, tree_node* last) {
+        if (first == last) {
+            return 0;
+        }
+        if (first == Leftmost() && last == root_) {
+            size_t count = size_;
+            clear();
+            if constexpr (kStats) {
+                stats_.erases_ += count;
+            }
+            return count;
+        }
+        size_t limit = size_ / std::bit_width(size_);
+        size_t count = 0;
+        tree_node* node = first;
+        while (node != last && count <= limit) {
+            node = (++Iterator<false, Inorder>(node)).it_;
+            ++count;
+        }
+        if (node == last) {
+            for (node = first; node != last; --size_) {
+                tree_node* next = (++Iterator<false, Inorder>(node)).it_;
+                DeleteNode(node);
+                node = next;
+            }
+            return count;
+        }
+        tree_node* head = Flatten(root_->left_);
+        tree_node** link = &head;
+        while (*link != first) {
+            link = &(*link)->right_;
+        }
+        count = 0;
+        for (node = first; node != nullptr && node != last; ++count) {
+            tree_node* next = node->right_;
+            delete_node(node);
+            node = next;
+        }
+        *link = node;
+        Rebuild(head, size_ - count);
+        if constexpr (kStats) {
+            stats_.erases_ += count;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Returns the black height of a subtree: the black nodes on each
+     * path down from its root, the root included (0 without RedBlack).
+     */
+    static size_t BlackHeight(const tree_node* node) {
+        size_t height = 0;
+        if constexpr (std::is_same_v<Balance, RedBlack>) {
+            for (; node != nullptr; node = node->left_) {
+                height += !node->red_;
+            }
+        }
+        return height;
+    }
+
+    /**
+     * @brief Replaces the contents with the join of two subtrees around a
+     * pivot node.
+     *
+     * Nothing of low may be greater than the pivot and nothing of high less.
+     * Under RedBlack the pivot is hung from the spine of the taller subtree
+     * at the black height of the shorter one and the result is repaired as
+     * after an insert, so the cost is O(1 + height difference). The counts
+     * and the cached maximum are left to the caller.
+     * @param low, high Subtree roots (may be nullptr); their old parent
+     * links are ignored.
+     * @param low_height, high_height Black heights of the subtrees.
+     * @return Black height of the result.
+     */
+    size_t JoinTrees(tree_node* low, size_t low_height, tree_node* pivot,
+                     tree_node* high, size_t high_height) {
+        if constexpr (std::is_same_v<Balance, RedBlack>) {
+            // A red root may be repainted black; it only adds a black level.
+            if (IsRed(low)) {
+                low->red_ = false;
+                ++low_height;
+            }
+            if (IsRed(high)) {
+                high->red_ = false;
+                ++high_height;
+            }
+            tree_node* parent = root_;
+            size_t height = std::max(low_height, high_height);
+            if (low_height >= high_height) {
+                tree_node* current = low;
+                while (current != nullptr && (current->red_ || height > high_height)) {
+                    height -= !current->red_;
+                    parent = current;
+                    current = current->right_;
+                }
+                pivot->left_ = current;
+                pivot->right_ = high;
+                root_->left_ = low;
+                (parent == root_ ? root_->left_ : parent->right_) = pivot;
+            } else {
+                tree_node* current = high;
+                while (current != nullptr && (current->red_ || height > low_height)) {
+                    height -= !current->red_;
+                    parent = current;
+                    current = current->left_;
+                }
+                pivot->left_ = low;
+                pivot->right_ = current;
+                root_->left_ = high;
+                parent->left_ = pivot;
+            }
+            root_->left_->parent_ = root_;
+            pivot->parent_ = parent;
+            if (pivot->left_ != nullptr) {
+                pivot->left_->parent_ = pivot;
+            }
+            if (pivot->right_ != nullptr) {
+                pivot->right_->parent_ = pivot;
+            }
+            RecountPath(pivot);
+            return std::max(low_height, high_height) +
+                   InsertFixup(pivot, RedBlack());
+        } else {
+            pivot->left_ = low;
+            pivot->right_ = high;
+            pivot->parent_ = root_;
+            root_->left_ = pivot;
+            if (low != nullptr) {
+                low->parent_ = pivot;
+            }
+            if (high != nullptr) {
+                high->parent_ = pivot;
+            }
+            Recount(pivot);
+            return 0;
+        }
+    }
+
+    /** @brief A unit of parallel work: a whole subtree or a single node. */
+    struct SubtreeTask {
+        tree_node* node_;
+        bool whole_;
+    };
+
+    /**
+     * @brief Cuts the tree into an In-order sequence of subtrees and nodes.
+     *
+     * Subtrees are split (left subtree, root, right subtree) level by level
+     * until there are at least `target` of them. With subtree sizes only
+     * the subtrees larger than size/target are split, so a skewed tree
+     * still yields balanced pieces.
+     * @param target Desired number of subtree pieces.
+     */
+    std::vector<SubtreeTask> SplitTasks(size_t target) const {
+        std::vector<SubtreeTask> tasks;
+        if (root_->left_ != nullptr) {
+            tasks.push_back({root_->left_, true});
+        }
+        size_t limit = size_ / target;
+        for (size_t pass = 0; pass < 64; ++pass) {
+            std::vector<SubtreeTask> split;
+            size_t pieces = 0;
+            bool changed = false;
+            for (SubtreeTask task : tasks) {
+                tree_node* node = task.node_;
+                bool small = node->left_ == nullptr && node->right_ == nullptr;
+                if constexpr (kSubtreeSize) {
+                    small = small || SizeOf(node) <= limit;
+                }
+                if (!task.whole_ || small) {
+                    split.push_back(task);
+                    pieces += task.whole_;
+                    continue;
+                }
+                if (node->left_ != nullptr) {
+                    split.push_back({node->left_, true});
+                    ++pieces;
+                }
+                split.push_back({node, false});
+                if (node->right_ != nullptr) {
+                    split.push_back({node->right_, true});
+                    ++pieces;
+                }
+                changed = true;
+            }
+            tasks = std::move(split);
+            if (!changed || pieces >= target) {
+                break;
+            }
+        }
+        return tasks;
+    }
+
+    /** @brief Visits the elements of a task in order. */
+    template <class Fn>
+    static void VisitTask(const SubtreeTask& task, Fn& fn) {
+        if (!task.whole_) {
+            fn(std::as_const(task.node_->data_));
+            return;
+        }
+        ScanInorder(task.node_,
+                    [&](tree_node* node) { fn(std::as_const(node->data_)); });
+    }
+
+    /**
+     * @brief Calls fn on every node of a subtree in In-order.
+     *
+     * Pending ancestors are kept on a bounded local stack, so each node is
+     * loaded once and the walk never climbs parent links to find the next
+     * one. Left chains deeper than the stack (only possible without
+     * balancing) spill it; spilled ancestors are then found by climbing.
+     * @param subtree Root of the subtree, may be null.
+     * @param fn Callable taking tree_node*.
+     */
+    template <class Fn>
+    static void ScanInorder(tree_node* subtree, Fn&& fn) {
+        tree_node* stack[kScanDepth];
+        size_t depth = 0;
+        size_t spilled = 0;
+        tree_node* node = subtree;
+        tree_node* visited = nullptr;
+        for (;;) {
+            for (; node != nullptr; node = node->left_) {
+                if (depth == kScanDepth) {
+                    spilled += depth;
+                    depth = 0;
+                }
+                stack[depth++] = node;
+            }
+            if (depth != 0) {
+                visited = stack[--depth];
+            } else if (spilled != 0) {
+                // The next ancestor is the first one reached from a left child.
+                while (visited == visited->parent_->right_) {
+                    visited = visited->parent_;
+                }
+                visited = visited->parent_;
+                --spilled;
+            } else {
+                return;
+            }
+            node = visited->right_;
+            fn(visited);
+        }
+    }
+
+    /** @brief Stably sorts a batch on the calling thread. */
+    void SortBatch(std::vector<T>& batch, Sequential) const {
+        std::stable_sort(batch.begin(), batch.end(), comp_);
+    }
+
+    /**
+     * @brief Stably sorts a batch with several threads.
+     *
+     * Each thread sorts one slice, then neighbouring runs are merged in
+     * rounds that double the run length, the merges of a round in parallel.
+     */
+    void SortBatch(std::vector<T>& batch, Parallel policy) const {
+        size_t threads = ThreadCount(policy, batch.size() / kSortSlice);
+        if (threads == 1) {
+            SortBatch(batch, Sequential());
+            return;
+        }
+        size_t n = batch.size();
+        size_t run = (n + threads - 1) / threads;
+        auto at = [&](size_t i) { return batch.begin() + std::min(i, n); };
+        RunTasks(threads, threads, [&](size_t i) {
+            std::stable_sort(at(i * run), at((i + 1) * run), comp_);
+        });
+        for (; run < n; run *= 2) {
+            size_t pairs = (n + 2 * run - 1) / (2 * run);
+            RunTasks(pairs, threads, [&](size_t i) {
+                size_t first = 2 * i * run;
+                std::inplace_merge(at(first), at(first + run), at(first + 2 * run),
+                                   comp_);
+            });
+        }
+    }
+
+   public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = Iterator<false, Inorder>;
+    using const_iterator = Iterator<true, Inorder>;
+    using node_type = NodeHandle;
+
+    /**
+     * @brief Default constructor. Initializes an empty tree with a sentinel root.
+     */
+    BST() : alloc_(Alloc()), comp_(Compare()), root_(&header_), rightmost_(&header_), size_(0) {}
+
+    /**
+     * @brief Creates an empty tree with the given comparator and allocator.
+     */
+    explicit BST(const Compare& comp, const Alloc& alloc = Alloc())
+        : alloc_(alloc), comp_(comp), root_(&header_), rightmost_(&header_), size_(0) {}
+
+    /** @brief Creates an empty tree using the given allocator. */
+    explicit BST(const Alloc& alloc) : BST(Compare(), alloc) {}
+
+    /**
+     * @brief Copy constructor. Performs a deep copy of another tree.
+     * @param other The tree to copy.
+     */
+    BST(const BST& other)
+        : alloc_(node_traits::select_on_container_copy_construction(
+              other.alloc_)),
+          comp_(other.comp_),
+          root_(&header_),
+          rightmost_(&header_),
+          size_(other.size_) {
+        root_->left_ = CopySubtree(other.root_->left_, root_);
+        ResetRightmost();
+    }
+
+    /**
+     * @brief Move constructor. Takes over the nodes in O(1).
+     * @param other The source tree, left empty.
+     */
+    BST(BST&& other) noexcept(std::is_nothrow_copy_constructible_v<Compare>)
+        : alloc_(std::move(other.alloc_)),
+          comp_(other.comp_),
+          root_(&header_),
+          rightmost_(&header_),
+          size_(0) {
+        StealNodes(other);
+    }
+
+    /**
+     * @brief Copy assignment operator.
+     * @param other The source tree.
+     * @return Reference to this tree.
+     */
+    BST& operator=(const BST& other) {
+        if (this != &other) {
+            clear();
+            if constexpr (node_traits::propagate_on_container_copy_assignment::value) {
+                alloc_ = other.alloc_;
+            }
+            comp_ = other.comp_;
+            root_->left_ = CopySubtree(other.root_->left_, root_);
+            ResetRightmost();
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * O(1) when the allocator propagates or compares equal; otherwise the
+     * elements are moved into nodes of this tree's allocator.
+     * @param other Rvalue reference to the source tree, left empty.
+     * @return Reference to this tree.
+     */
+    BST& operator=(BST&& other) noexcept(
+        (node_traits::propagate_on_container_move_assignment::value ||
+         node_traits::is_always_equal::value) &&
+        std::is_nothrow_move_assignable_v<Compare>) {
+        if (this != &other) {
+            MoveAssign(other,
+                       std::bool_constant<
+                           node_traits::propagate_on_container_move_assignment::value ||
+                           node_traits::is_always_equal::value>());
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Constructor that initializes the tree from a list of values.
+     * @param ilist Initializer list of elements.
+     */
+    BST(initializer_list<T> ilist) : BST() {
+        insert(ilist.begin(), ilist.end());
+    }
+
+    /**
+     * @brief Replaces contents with values from an initializer list.
      * @param ilist Initializer list.
      * @return Reference to this tree.
      */
@@ -532,7 +2199,12 @@ class BST {
     /**
      * @brief Destructor. Clears all nodes from the tree.
      */
-    ~BST() { ClearRecursive(root_); }
+    ~BST() {
+        if (ReleaseArena()) {
+            return;
+        }
+        ClearSubtree(root_->left_);
+    }
 
     /** @brief Returns an In-order iterator to the beginning. */
     Iterator<false, Inorder> begin(Inorder = Inorder()) {
@@ -544,6 +2216,12 @@ class BST {
         return Iterator<false, Inorder>(root_);
     }
 
+    /** @brief Returns a constant In-order iterator to the beginning. */
+    Iterator<true, Inorder> begin(Inorder = Inorder()) const { return cbegin(); }
+
+    /** @brief Returns the constant In-order end iterator (sentinel). */
+    Iterator<true, Inorder> end(Inorder = Inorder()) const { return cend(); }
+
     /** @brief Returns a constant In-order iterator to the beginning. */
     Iterator<true, Inorder> cbegin(Inorder = Inorder()) const {
         return Iterator<true, Inorder>(Leftmost());
@@ -556,7 +2234,7 @@ class BST {
 
     /** @brief Returns a Pre-order iterator to the beginning. */
     Iterator<false, Preorder> begin(Preorder) {
-        return Iterator<false, Preorder>(root_->left_);
+        return Iterator<false, Preorder>(empty() ? root_ : root_->left_);
     }
 
     /** @brief Returns a Pre-order iterator to the end (sentinel). */
@@ -566,7 +2244,7 @@ class BST {
 
     /** @brief Returns a constant Pre-order iterator to the beginning. */
     Iterator<true, Preorder> cbegin(Preorder) const {
-        return Iterator<true, Preorder>(root_->left_);
+        return Iterator<true, Preorder>(empty() ? root_ : root_->left_);
     }
 
     /** @brief Returns a constant Pre-order iterator to the end (sentinel). */
@@ -576,7 +2254,8 @@ class BST {
 
     /** @brief Returns a Post-order iterator to the beginning. */
     Iterator<false, Postorder> begin(Postorder) {
-        return Iterator<false, Postorder>(Leftmost(root_));
+        return Iterator<false, Postorder>(
+            Iterator<false, Postorder>::FirstPostorder(root_));
     }
 
     /** @brief Returns a Post-order iterator to the end (sentinel). */
@@ -586,7 +2265,8 @@ class BST {
 
     /** @brief Returns a constant Post-order iterator to the beginning. */
     Iterator<true, Postorder> cbegin(Postorder) const {
-        return Iterator<true, Postorder>(Leftmost(root_));
+        return Iterator<true, Postorder>(
+            Iterator<true, Postorder>::FirstPostorder(root_));
     }
 
     /** @brief Returns a constant Post-order iterator to the end (sentinel). */
@@ -630,67 +2310,393 @@ class BST {
     /** @brief Returns the total number of elements in the tree. */
     size_t size() const { return size_; }
 
-    /** @brief Returns the theoretical maximum number of nodes. */
-    size_t max_size() const {
-        return (std::numeric_limits<size_t>::max() - sizeof(BST)) / sizeof(Node<T>);
+    /** @brief Returns the theoretical maximum number of nodes. */
+    size_t max_size() const {
+        return (std::numeric_limits<size_t>::max() - sizeof(BST)) / sizeof(tree_node);
+    }
+
+    /**
+     * @brief Returns the number of levels on the longest root-to-leaf path.
+     *
+     * 0 for an empty tree and n for the chain that sorted input builds
+     * without a balancing policy. Linear time, constant stack.
+     */
+    size_t height() const {
+        size_t height = 0;
+        std::vector<std::pair<const tree_node*, size_t>> stack;
+        if (root_->left_ != nullptr) {
+            stack.emplace_back(root_->left_, 1);
+        }
+        while (!stack.empty()) {
+            auto [node, depth] = stack.back();
+            stack.pop_back();
+            height = std::max(height, depth);
+            if (node->left_ != nullptr) {
+                stack.emplace_back(node->left_, depth + 1);
+            }
+            if (node->right_ != nullptr) {
+                stack.emplace_back(node->right_, depth + 1);
+            }
+        }
+        return height;
+    }
+
+    /**
+     * @brief Checks the structural invariants of the tree.
+     *
+     * Verifies the parent links, the element order and count, the cached
+     * maximum, the red-black colouring under RedBlack and the subtree sizes
+     * under SubtreeSize.
+     * Linear time; meant for tests and health checks.
+     * @return True if every invariant holds.
+     */
+    bool validate() const {
+        if (root_->parent_ != nullptr || root_->right_ != nullptr) {
+            return false;
+        }
+        const tree_node* top = root_->left_;
+        if (top != nullptr && top->parent_ != root_) {
+            return false;
+        }
+        if constexpr (std::is_same_v<Balance, RedBlack>) {
+            if (IsRed(top)) {
+                return false;
+            }
+        }
+        // Each entry carries the number of black nodes above it.
+        std::vector<std::pair<const tree_node*, size_t>> stack;
+        std::optional<size_t> black_height;
+        size_t count = 0;
+        if (top != nullptr) {
+            stack.emplace_back(top, 0);
+        }
+        while (!stack.empty()) {
+            auto [node, blacks] = stack.back();
+            stack.pop_back();
+            ++count;
+            if constexpr (kSubtreeSize) {
+                if (node->subtree_size_ !=
+                    1 + SizeOf(node->left_) + SizeOf(node->right_)) {
+                    return false;
+                }
+            }
+            if constexpr (std::is_same_v<Balance, RedBlack>) {
+                if (node->red_ && (IsRed(node->left_) || IsRed(node->right_))) {
+                    return false;
+                }
+                blacks += !node->red_;
+            }
+            for (const tree_node* child : {node->left_, node->right_}) {
+                if (child != nullptr) {
+                    if (child->parent_ != node) {
+                        return false;
+                    }
+                    stack.emplace_back(child, blacks);
+                } else if (!black_height) {
+                    black_height = blacks;
+                } else if (*black_height != blacks) {
+                    return false;
+                }
+            }
+        }
+        if (count != size_) {
+            return false;
+        }
+        const tree_node* last = root_;
+        for (const tree_node* node = top; node != nullptr; node = node->right_) {
+            last = node;
+        }
+        if (last != rightmost_) {
+            return false;
+        }
+        const T* previous = nullptr;
+        bool ordered = true;
+        ScanInorder(root_->left_, [&](tree_node* node) {
+            ordered = ordered && (previous == nullptr || !comp_(node->data_, *previous));
+            previous = &node->data_;
+        });
+        return ordered;
+    }
+
+    /** @brief Returns a copy of the counters (CollectStats policy only). */
+    TreeStats stats() const {
+        static_assert(kStats, "stats() requires the CollectStats policy");
+        return stats_;
+    }
+
+    /** @brief Zeroes the counters (CollectStats policy only). */
+    void reset_stats() {
+        static_assert(kStats, "reset_stats() requires the CollectStats policy");
+        stats_ = TreeStats();
+    }
+
+    /**
+     * @brief Reports the heap memory of the nodes.
+     *
+     * With an arena allocator the whole arena is counted, including free
+     * blocks left behind by erases and anything other trees sharing the
+     * arena allocated.
+     */
+    MemoryUsage memory_usage() const {
+        MemoryUsage usage;
+        usage.node_bytes_ = size_ * sizeof(tree_node);
+        if constexpr (requires(const node_allocator_type& alloc) {
+                          { alloc.pool().reserved_bytes() } -> std::same_as<size_t>;
+                      }) {
+            usage.allocated_bytes_ = alloc_.pool().reserved_bytes();
+        } else {
+            usage.allocated_bytes_ = usage.node_bytes_;
+        }
+        return usage;
+    }
+
+    /**
+     * @brief Moves the elements into freshly allocated nodes laid out in
+     * In-order, restoring scan locality after erase churn.
+     *
+     * The new nodes come from the allocator a copy of the tree would use
+     * and are allocated one after another in element order. With
+     * PoolAllocator that is a fresh arena, so an In-order scan walks memory
+     * sequentially; other allocators give no layout guarantee. The old
+     * nodes, with their arena, are then released. The shape is rebuilt
+     * balanced in O(n). Elements are moved if that cannot throw, otherwise
+     * copied; if anything throws the tree is left holding its elements.
+     * Requires an allocator that propagates on move assignment or is always
+     * equal, so that the tree can own the new nodes. Invalidates all
+     * iterators and node handles.
+     */
+    void compact() {
+        constexpr bool kPropagate =
+            node_traits::propagate_on_container_move_assignment::value;
+        static_assert(kPropagate || node_traits::is_always_equal::value,
+                      "compact() requires an allocator that propagates on move "
+                      "assignment or is always equal");
+        if (size_ == 0) {
+            clear();
+            return;
+        }
+        BST fresh(comp_, Alloc(node_traits::select_on_container_copy_construction(alloc_)));
+        if constexpr (kStats) {
+            fresh.stats_ = stats_; // Its allocations continue our counters
+        }
+        tree_node* old = Flatten(root_->left_);
+        // Allocate every node first so that no element is moved from
+        // before the last allocation has succeeded.
+        tree_node* head = nullptr;
+        tree_node** tail = &head;
+        size_t constructed = 0;
+        try {
+            for (size_t i = 0; i < size_; ++i) {
+                *tail = fresh.alloc_node();
+                tail = &(*tail)->right_;
+            }
+            tree_node* slot = head;
+            for (tree_node* node = old; node != nullptr; node = node->right_) {
+                node_traits::construct(fresh.alloc_, std::addressof(slot->data_),
+                                       std::move_if_noexcept(node->data_));
+                ++constructed;
+                slot = slot->right_;
+            }
+        } catch (...) {
+            while (head != nullptr) {
+                tree_node* next = head->right_;
+                if (constructed != 0) {
+                    node_traits::destroy(fresh.alloc_, std::addressof(head->data_));
+                    --constructed;
+                }
+                fresh.free_node(head);
+                head = next;
+            }
+            Rebuild(old, size_);
+            throw;
+        }
+        fresh.Rebuild(head, size_);
+        if constexpr (kStats) {
+            stats_ = fresh.stats_;
+        }
+        if (!ReleaseArena()) {
+            DeleteList(old);
+        }
+        if constexpr (kPropagate) {
+            alloc_ = fresh.alloc_;
+        }
+        StealNodes(fresh);
+        if constexpr (kStats) {
+            ++stats_.rebuilds_;
+        }
+    }
+
+    /** @brief Removes all user elements from the tree. */
+    void clear() {
+        if (!ReleaseArena()) {
+            ClearSubtree(root_->left_);
+        }
+        root_->left_ = nullptr;
+        rightmost_ = root_;
+        size_ = 0;
+    }
+
+    /**
+     * @brief Swaps contents with another BST instance in O(1).
+     *
+     * The allocators are swapped when they propagate on swap; otherwise
+     * they must compare equal. End iterators keep referring to their own
+     * tree, all other iterators follow their elements.
+     */
+    void swap(BST& other) noexcept(std::is_nothrow_swappable_v<Compare>) {
+        using std::swap;
+        if constexpr (node_traits::propagate_on_container_swap::value) {
+            swap(alloc_, other.alloc_);
+        }
+        swap(comp_, other.comp_);
+        swap(root_->left_, other.root_->left_);
+        swap(rightmost_, other.rightmost_);
+        swap(size_, other.size_);
+        if (root_->left_ != nullptr) {
+            root_->left_->parent_ = root_;
+        } else {
+            rightmost_ = root_;
+        }
+        if (other.root_->left_ != nullptr) {
+            other.root_->left_->parent_ = other.root_;
+        } else {
+            other.rightmost_ = other.root_;
+        }
+    }
+
+    /**
+     * @brief Inserts a new value into the BST.
+     * @param value The value to insert.
+     * @return A pair containing the iterator to the element and a success flag.
+     */
+    template <class Pick = Inorder>
+    pair<Iterator<false, Pick>, bool> insert(const T& value, Pick = Inorder()) {
+        return {Iterator<false, Pick>(InsertNode(create_node(value))), true};
+    }
+
+    /** @brief Inserts a value by moving it into the new node. */
+    template <class Pick = Inorder>
+    pair<Iterator<false, Pick>, bool> insert(T&& value, Pick = Inorder()) {
+        return {Iterator<false, Pick>(InsertNode(create_node(std::move(value)))),
+                true};
+    }
+
+    /**
+     * @brief Constructs a value in place and inserts it.
+     * @param args Arguments forwarded to the constructor of T.
+     * @return A pair containing the iterator to the element and a success flag.
+     */
+    template <class... Args>
+    pair<Iterator<false, Inorder>, bool> emplace(Args&&... args) {
+        return {Iterator<false, Inorder>(
+                    InsertNode(create_node(std::forward<Args>(args)...))),
+                true};
+    }
+
+    /**
+     * @brief Constructs a value in place, inserting it just before the hint
+     * when that keeps the order; otherwise finger-searches from the hint.
+     *
+     * Appends with end() as the hint take O(1) amortized time, and a hint d
+     * positions from the insertion point costs O(log d) comparisons.
+     * @param hint In-order position the new element should precede.
+     * @return Iterator to the inserted element.
+     */
+    template <bool IsConst, class... Args>
+    Iterator<false, Inorder> emplace_hint(Iterator<IsConst, Inorder> hint,
+                                          Args&&... args) {
+        tree_node* node = create_node(std::forward<Args>(args)...);
+        return Iterator<false, Inorder>(
+            InsertNodeHint(const_cast<tree_node*>(hint.it_), node));
     }
 
-    /** @brief Removes all user elements from the tree. */
-    void clear() {
-        ClearRecursive(root_->left_);
-        root_->left_ = nullptr;
-        size_ = 0;
+    /**
+     * @brief Inserts a copy of the value near a hint, see emplace_hint().
+     * @return Iterator to the inserted element.
+     */
+    template <bool IsConst>
+    Iterator<false, Inorder> insert(Iterator<IsConst, Inorder> hint,
+                                    const T& value) {
+        return emplace_hint(hint, value);
     }
 
-    /** @brief Swaps contents with another BST instance. */
-    void swap(BST& other) {
-        Node<T>* temp = root_;
-        root_ = other.root_;
-        other.root_ = temp;
+    /** @brief Moves the value into the tree near a hint, see emplace_hint(). */
+    template <bool IsConst>
+    Iterator<false, Inorder> insert(Iterator<IsConst, Inorder> hint, T&& value) {
+        return emplace_hint(hint, std::move(value));
     }
 
     /**
-     * @brief Inserts a new value into the BST.
-     * @param value The value to insert.
-     * @return A pair containing the iterator to the element and a success flag.
+     * @brief Inserts a batch of unsorted values in one merge pass.
+     *
+     * The batch is copied and stably sorted, so equal values keep their
+     * batch order, then merged as by insert_sorted(): a batch that is large
+     * next to the tree is merged with the flattened tree and rebuilt in
+     * linear time, a small one is linked by finger search from each
+     * previous position.
+     * @param values The values to insert.
+     * @param policy Sequential, or Parallel to sort on several threads.
      */
-    template <class Pick = Inorder>
-    pair<Iterator<false, Pick>, bool> insert(const T& value, Pick = Inorder()) {
-        Node<T>* current = root_->left_;
-        Node<T>* parent = root_;
-        while (current != nullptr) {
-            parent = current;
-            if (comp_(value, current->data_)) {
-                current = current->left_;
-            } else {
-                current = current->right_;
-            }
-        }
-        Node<T>* newNode = alloc_node();
-        newNode->data_ = value;
-        newNode->parent_ = parent;
-        newNode->left_ = nullptr;
-        newNode->right_ = nullptr;
-        if (parent->parent_ == nullptr) {
-            root_->left_ = newNode;
-        } else if (comp_(value, parent->data_)) {
-            parent->left_ = newNode;
-        } else {
-            parent->right_ = newNode;
-        }
-        size_++;
-        return {Iterator<false, Pick>(newNode), true};
+    template <class Policy = Sequential>
+    void insert_batch(std::span<const T> values, Policy policy = Policy()) {
+        std::vector<T> batch(values.begin(), values.end());
+        SortBatch(batch, policy);
+        insert_sorted(std::make_move_iterator(batch.begin()),
+                      std::make_move_iterator(batch.end()));
     }
 
-    /** @brief Inserts a range of elements. */
+    /**
+     * @brief Inserts a range of elements.
+     *
+     * Into an empty tree a sorted forward range is detected and built in
+     * linear time by insert_sorted(). A populated tree takes the elements
+     * one by one, so its existing nodes stay in place; call insert_sorted()
+     * to opt into the merge.
+     */
     template <class InputIt>
     void insert(InputIt first, InputIt last) {
+        if constexpr (std::forward_iterator<InputIt>) {
+            if (size_ == 0 && std::is_sorted(first, last, comp_)) {
+                insert_sorted(first, last);
+                return;
+            }
+        }
         while (first != last) {
-            insert(*first);
+            emplace(*first);
             ++first;
         }
     }
 
+    /**
+     * @brief Inserts a range already sorted by the comparator.
+     *
+     * Into an empty tree (or when the range is large relative to the tree)
+     * the nodes are merged with the existing ones and the whole tree is
+     * rebuilt perfectly balanced in linear time; small ranges are inserted
+     * one by one.
+     * @param first Beginning of the sorted range.
+     * @param last End of the sorted range.
+     */
+    template <class InputIt>
+    void insert_sorted(InputIt first, InputIt last) {
+        size_t count = 0;
+        tree_node* head = CreateList(first, last, count);
+        MergeNodes(head, count);
+    }
+
+    /**
+     * @brief Builds a perfectly balanced tree from a sorted range in O(n).
+     * @param first Beginning of the sorted range.
+     * @param last End of the sorted range.
+     * @return The new tree.
+     */
+    template <class InputIt>
+    static BST from_sorted(InputIt first, InputIt last) {
+        BST tree;
+        tree.insert_sorted(first, last);
+        return tree;
+    }
+
     /** @brief Inserts elements from an initializer list. */
     void insert(initializer_list<T> il) { insert(il.begin(), il.end()); }
 
@@ -709,7 +2715,7 @@ class BST {
         if (it == end(Pick())) {
             return it;
         }
-        Node<T>* node = it.it_;
+        tree_node* node = it.it_;
         ++it;
         DeleteNode(node);
         --size_;
@@ -722,7 +2728,7 @@ class BST {
         if (it == cend(Pick())) {
             return it;
         }
-        Node<T>* node = const_cast<Node<T>*>(it.it_);
+        tree_node* node = const_cast<tree_node*>(it.it_);
         ++it;
         DeleteNode(node);
         --size_;
@@ -734,72 +2740,368 @@ class BST {
      * @return The number of elements removed.
      */
     size_t erase(const T& value) {
-        size_t count = 0;
-        auto it = find(value);
-        while (it != end()) {
-            erase(it);
-            ++count;
-            it = find(value);
-        }
-        return count;
+        return EraseNodes(LowerBoundNode(value), UpperBoundNode(value));
     }
 
-    /** @brief Erases a range of elements. */
+    /**
+     * @brief Erases a range of elements.
+     *
+     * In-order ranges are removed in bulk (see EraseNodes); other traversal
+     * orders are not contiguous in key order and are erased one by one.
+     */
     template <class Pick>
     void erase(Iterator<false, Pick> first, Iterator<false, Pick> last) {
-        while (first != last) {
-            erase(first++);
+        if constexpr (std::is_same_v<Pick, Inorder>) {
+            EraseNodes(first.it_, last.it_);
+        } else {
+            while (first != last) {
+                erase(first++);
+            }
         }
     }
 
     /** @brief Constant range erase. */
     template <class Pick>
     void erase(Iterator<true, Pick> first, Iterator<true, Pick> last) {
-        while (first != last) {
-            erase(first++);
+        if constexpr (std::is_same_v<Pick, Inorder>) {
+            EraseNodes(const_cast<tree_node*>(first.it_),
+                       const_cast<tree_node*>(last.it_));
+        } else {
+            while (first != last) {
+                erase(first++);
+            }
         }
     }
 
-    /** @brief Extracts and returns a value while removing it from the tree. */
+    /**
+     * @brief Unlinks an element and hands its node over, without freeing
+     * or copying it.
+     * @param it Iterator to the element; end() yields an empty handle.
+     * @return Handle owning the node.
+     */
     template <class Pick>
-    T extract(Iterator<false, Pick> it) {
-        T value = *it;
-        erase(it);
-        return value;
+    node_type extract(Iterator<false, Pick> it) {
+        return ExtractNode(it.it_);
     }
 
     /** @brief Constant extract. */
     template <class Pick>
-    T extract(Iterator<true, Pick> it) {
-        T value = *it;
-        erase(it);
-        return value;
+    node_type extract(Iterator<true, Pick> it) {
+        return ExtractNode(const_cast<tree_node*>(it.it_));
+    }
+
+    /**
+     * @brief Extracts the first element equal to the value.
+     * @return Handle owning its node, or an empty handle if absent.
+     */
+    node_type extract(const T& value) { return ExtractNode(FindNode(value)); }
+
+    /**
+     * @brief Relinks an extracted node at its upper-bound position.
+     *
+     * The node is reused as is when the handle's allocator equals this
+     * tree's; otherwise the value is moved into a node of this tree.
+     * @param node Handle to insert from; left empty.
+     * @return Iterator to the inserted element, or end() for an empty handle.
+     */
+    iterator insert(node_type&& node) {
+        if (node.empty()) {
+            return end();
+        }
+        return iterator(InsertNode(AdoptNode(node)));
+    }
+
+    /**
+     * @brief Relinks an extracted node near a hint, see emplace_hint().
+     * @return Iterator to the inserted element, or end() for an empty handle.
+     */
+    template <bool IsConst>
+    iterator insert(Iterator<IsConst, Inorder> hint, node_type&& node) {
+        if (node.empty()) {
+            return end();
+        }
+        return iterator(
+            InsertNodeHint(const_cast<tree_node*>(hint.it_), AdoptNode(node)));
     }
 
-    /** @brief Extracts an element matching the value. */
-    T extract(const T& value) {
-        auto it = find(value);
-        return extract(it);
+    /**
+     * @brief Merges copies of another tree's elements into this one.
+     *
+     * Runs as a linear merge of both in-order sequences when the other tree
+     * is not much smaller than this one.
+     */
+    void merge(const BST& other) {
+        size_t count = 0;
+        tree_node* head = CreateList(other.cbegin(), other.cend(), count);
+        MergeNodes(head, count);
     }
 
-    /** @brief Merges another tree's contents into this one. */
-    void merge(const BST& other) { insert_range(other); }
+    /**
+     * @brief Moves all nodes of another tree into this one without
+     * reallocating; the source is left empty.
+     *
+     * Falls back to copying when the allocators differ.
+     */
+    void merge(BST&& other) {
+        if (this == &other) {
+            return;
+        }
+        if (!(alloc_ == other.alloc_)) {
+            merge(other);
+            other.clear();
+            return;
+        }
+        size_t count = other.size_;
+        tree_node* head = Flatten(other.root_->left_);
+        other.root_->left_ = nullptr;
+        other.rightmost_ = other.root_;
+        other.size_ = 0;
+        MergeNodes(head, count);
+    }
 
-    /** @brief Counts occurrences of a specific value. */
-    size_t count(const T& value) const {
-        Node<T>* current = root_->left_;
+    /**
+     * @brief Multiset union: keeps max(count in this, count in other) of
+     * every value. Linear in the size of both trees.
+     */
+    void union_with(const BST& other) {
+        tree_node* mine = Flatten(root_->left_);
+        tree_node* head = nullptr;
+        tree_node** tail = &head;
         size_t count = 0;
-        while (current != nullptr) {
-            if (current->data_ == value) {
-                count++;
+        auto it = other.cbegin();
+        try {
+            while (it != other.cend()) {
+                if (mine != nullptr && comp_(mine->data_, *it)) {
+                    *tail = mine;
+                    mine = mine->right_;
+                } else if (mine == nullptr || comp_(*it, mine->data_)) {
+                    *tail = create_node(*it);
+                    ++it;
+                } else {
+                    *tail = mine;
+                    mine = mine->right_;
+                    ++it;
+                }
+                tail = &(*tail)->right_;
+                ++count;
             }
-            if (comp_(value, current->data_)) {
-                current = current->left_;
+        } catch (...) {
+            *tail = nullptr;
+            Rebuild(MergeLists(head, mine), count + ListLength(mine));
+            throw;
+        }
+        *tail = mine;
+        Rebuild(head, count + ListLength(mine));
+    }
+
+    /**
+     * @brief Multiset intersection: keeps min(count in this, count in other)
+     * of every value. Linear in the size of both trees.
+     */
+    void intersect_with(const BST& other) {
+        tree_node* mine = Flatten(root_->left_);
+        tree_node* head = nullptr;
+        tree_node** tail = &head;
+        size_t count = 0;
+        auto it = other.cbegin();
+        while (mine != nullptr) {
+            tree_node* next = mine->right_;
+            if (it == other.cend() || comp_(mine->data_, *it)) {
+                delete_node(mine);
+            } else if (comp_(*it, mine->data_)) {
+                ++it;
+                continue;
             } else {
-                current = current->right_;
+                *tail = mine;
+                tail = &mine->right_;
+                ++count;
+                ++it;
             }
+            mine = next;
         }
-        return count;
+        *tail = nullptr;
+        Rebuild(head, count);
+    }
+
+    /**
+     * @brief Multiset difference: removes one occurrence of this tree's
+     * elements per occurrence in the other. Linear in both sizes.
+     */
+    void difference(const BST& other) {
+        tree_node* mine = Flatten(root_->left_);
+        tree_node* head = nullptr;
+        tree_node** tail = &head;
+        size_t count = 0;
+        auto it = other.cbegin();
+        while (mine != nullptr) {
+            tree_node* next = mine->right_;
+            if (it == other.cend() || comp_(mine->data_, *it)) {
+                *tail = mine;
+                tail = &mine->right_;
+                ++count;
+            } else if (comp_(*it, mine->data_)) {
+                ++it;
+                continue;
+            } else {
+                delete_node(mine);
+                ++it;
+            }
+            mine = next;
+        }
+        *tail = nullptr;
+        Rebuild(head, count);
+    }
+
+    /**
+     * @brief Splits the tree at a key, leaving this tree empty.
+     *
+     * Nodes are relinked, never copied: each node on the search path is
+     * joined with the subtree on its far side into one part or the other.
+     * Under RedBlack those joins telescope to O(log n) in total. With the
+     * SubtreeSize augmentation the part sizes come for free and the split
+     * is O(log n); without it the smaller part, of k elements, is walked to
+     * count it, for O(log n + k). Other balance policies pay O(height) for
+     * the relinking instead of O(log n).
+     * @param key The split point.
+     * @return The elements less than the key, and the rest.
+     */
+    pair<BST, BST> split(const T& key) {
+        pair<BST, BST> parts(BST(comp_, get_allocator()), BST(comp_, get_allocator()));
+        BST& low = parts.first;
+        BST& high = parts.second;
+        std::vector<pair<tree_node*, size_t>> path;
+        size_t height = BlackHeight(root_->left_);
+        for (tree_node* node = root_->left_; node != nullptr;) {
+            path.emplace_back(node, height);
+            if constexpr (std::is_same_v<Balance, RedBlack>) {
+                height -= !node->red_;
+            }
+            node = Child(node, Less(node->data_, key));
+        }
+        size_t low_height = 0;
+        size_t high_height = 0;
+        // Deepest first, each node brackets the parts built below it.
+        for (auto step = path.rbegin(); step != path.rend(); ++step) {
+            auto [node, node_height] = *step;
+            size_t child_height = node_height;
+            if constexpr (std::is_same_v<Balance, RedBlack>) {
+                child_height -= !node->red_;
+            }
+            if (Less(node->data_, key)) {
+                low_height = low.JoinTrees(node->left_, child_height, node,
+                                           low.root_->left_, low_height);
+            } else {
+                high_height = high.JoinTrees(high.root_->left_, high_height, node,
+                                             node->right_, child_height);
+            }
+        }
+        if constexpr (kSubtreeSize) {
+            low.size_ = SizeOf(low.root_->left_);
+        } else {
+            // Step in from both ends so only the smaller part is walked.
+            auto forward = low.cbegin();
+            auto backward = high.cend();
+            size_t steps = 0;
+            while (forward != low.cend() && backward != high.cbegin()) {
+                ++forward;
+                --backward;
+                ++steps;
+            }
+            low.size_ = forward == low.cend() ? steps : size_ - steps;
+        }
+        high.size_ = size_ - low.size_;
+        low.ResetRightmost();
+        high.ResetRightmost();
+        root_->left_ = nullptr;
+        rightmost_ = root_;
+        size_ = 0;
+        return parts;
+    }
+
+    /**
+     * @brief Concatenates two trees whose ranges do not overlap.
+     *
+     * The minimum of high is unlinked as the pivot, and the rest of high is
+     * hung under it next to low. Nodes are relinked, never copied, in
+     * O(log n) under RedBlack. Trees with unequal allocators are merged
+     * element by element instead.
+     * @param low Tree whose elements are all not greater than those of high.
+     * @param high The other tree; both are left empty.
+     * @return The joined tree.
+     * @throws std::invalid_argument if an element of low is greater than an
+     * element of high; both trees are then left unchanged.
+     */
+    static BST join(BST&& low, BST&& high) {
+        if (!low.empty() && !high.empty() &&
+            low.comp_(high.Leftmost()->data_, low.rightmost_->data_)) {
+            throw std::invalid_argument("join: ranges overlap");
+        }
+        if (low.empty()) {
+            return BST(std::move(high));
+        }
+        BST result(std::move(low));
+        if (high.empty()) {
+            return result;
+        }
+        if (!(result.alloc_ == high.alloc_)) {
+            result.merge(std::move(high));
+            return result;
+        }
+        tree_node* pivot = high.Leftmost();
+        high.UnlinkNode(pivot);
+        tree_node* top = result.root_->left_;
+        result.JoinTrees(top, BlackHeight(top), pivot, high.root_->left_,
+                         BlackHeight(high.root_->left_));
+        result.rightmost_ = high.size_ > 1 ? high.rightmost_ : pivot;
+        result.size_ += high.size_;
+        high.root_->left_ = nullptr;
+        high.rightmost_ = high.root_;
+        high.size_ = 0;
+        return result;
+    }
+
+    /**
+     * @brief Counts occurrences of a specific value.
+     *
+     * O(height) with SubtreeSize, otherwise O(height + count).
+     */
+    size_t count(const T& value) const { return CountEqual(value); }
+
+    /**
+     * @brief Returns an iterator to the element at a given in-order index.
+     * Requires the SubtreeSize augmentation.
+     * @param k Zero-based index.
+     * @return Iterator to the element, or end() if k >= size().
+     */
+    Iterator<false, Inorder> nth(size_t k) {
+        return Iterator<false, Inorder>(NthNode(k));
+    }
+
+    /** @brief Constant version of nth. */
+    Iterator<true, Inorder> nth(size_t k) const {
+        return Iterator<true, Inorder>(NthNode(k));
+    }
+
+    /**
+     * @brief Returns the number of elements less than a value, i.e. the
+     * index of lower_bound(value). Requires the SubtreeSize augmentation.
+     */
+    size_t rank(const T& value) const {
+        static_assert(kSubtreeSize, "rank() requires the SubtreeSize augmentation");
+        return Rank(value, false);
+    }
+
+    /**
+     * @brief Counts the elements in [lo, hi) in O(height).
+     * Requires the SubtreeSize augmentation.
+     */
+    size_t count_range(const T& lo, const T& hi) const {
+        static_assert(kSubtreeSize,
+                      "count_range() requires the SubtreeSize augmentation");
+        if (!comp_(lo, hi)) {
+            return 0;
+        }
+        return Rank(hi, false) - Rank(lo, false);
     }
 
     /**
@@ -808,51 +3110,84 @@ class BST {
      */
     template <class Pick = Inorder>
     Iterator<false, Pick> find(const T& value, Pick = Inorder()) {
-        auto it = begin(Pick());
-        while (it != end(Pick()) && *it != value) {
-            ++it;
-        }
-        return it;
+        return Iterator<false, Pick>(FindNode(value));
     }
 
     /** @brief Constant version of find. */
     template <class Pick = Inorder>
     Iterator<true, Pick> find(const T& value, Pick = Inorder()) const {
-        auto it = cbegin(Pick());
-        while (it != cend(Pick()) && *it != value) {
-            ++it;
-        }
-        return it;
+        return Iterator<true, Pick>(FindNode(value));
     }
 
     /** @brief Finds the last occurrence of a value. */
     template <class Pick = Inorder>
     Iterator<false, Pick> rfind(const T& value, Pick = Inorder()) {
-        auto it = find(value, Pick());
-        while (it != end(Pick()) && *it == value) {
-            ++it;
-        }
-        if (it != end(Pick())) {
-            --it;
-        }
-        return it;
+        return Iterator<false, Pick>(RFindNode(value));
     }
 
     /** @brief Constant version of rfind. */
     template <class Pick = Inorder>
     Iterator<true, Pick> rfind(const T& value, Pick = Inorder()) const {
-        auto it = find(value, Pick());
-        while (it != cend(Pick()) && *it == value) {
-            ++it;
-        }
-        if (it != cend(Pick())) {
-            --it;
-        }
-        return it;
+        return Iterator<true, Pick>(RFindNode(value));
+    }
+
+    /**
+     * @brief Finds the first occurrence of a value, searching from a hint.
+     *
+     * Walks up from the hint only as far as needed before descending, so a
+     * value d positions from the hint costs O(log d) comparisons.
+     * @param hint Any In-order iterator of this tree, end() included.
+     * @param value The value to find.
+     */
+    template <bool IsConst>
+    Iterator<false, Inorder> find_from(Iterator<IsConst, Inorder> hint,
+                                       const T& value) {
+        return Iterator<false, Inorder>(
+            FingerFind(const_cast<tree_node*>(hint.it_), value));
+    }
+
+    /** @brief Constant version of find_from. */
+    template <bool IsConst>
+    Iterator<true, Inorder> find_from(Iterator<IsConst, Inorder> hint,
+                                      const T& value) const {
+        return Iterator<true, Inorder>(
+            FingerFind(const_cast<tree_node*>(hint.it_), value));
     }
 
     /** @brief Checks if the value exists in the tree. */
-    bool contains(const T& value) const { return find(value) != cend(); }
+    bool contains(const T& value) const { return FindNode(value) != root_; }
+
+    /**
+     * @brief Finds a batch of keys at once, interleaving their descents.
+     * @param keys The keys to look up.
+     * @param out Receives find(keys[i]) at index i; must hold keys.size()
+     * iterators.
+     */
+    void find_batch(std::span<const T> keys, std::span<iterator> out) {
+        FindBatch(keys, [&](size_t i, tree_node* node) {
+            out[i] = iterator(node);
+        });
+    }
+
+    /** @brief Constant version of find_batch. */
+    void find_batch(std::span<const T> keys,
+                    std::span<const_iterator> out) const {
+        FindBatch(keys, [&](size_t i, tree_node* node) {
+            out[i] = const_iterator(node);
+        });
+    }
+
+    /**
+     * @brief Checks a batch of keys at once, interleaving their descents.
+     * @param keys The keys to look up.
+     * @param out Receives contains(keys[i]) at index i; must hold
+     * keys.size() flags.
+     */
+    void contains_batch(std::span<const T> keys, std::span<bool> out) const {
+        FindBatch(keys, [&](size_t i, tree_node* node) {
+            out[i] = node != root_;
+        });
+    }
 
     /** @brief Returns a range of elements matching the value. */
     template <class Pick = Inorder>
@@ -868,36 +3203,332 @@ class BST {
         return {lower_bound(value, Pick()), upper_bound(value, Pick())};
     }
 
-    /** @brief Returns the lower bound for a value. */
+    /**
+     * @brief Returns the lower bound for a value.
+     * @return Iterator to the first element not less than the value.
+     */
     template <class Pick = Inorder>
     Iterator<false, Pick> lower_bound(const T& value, Pick = Inorder()) {
-        return find(value, Pick());
+        return Iterator<false, Pick>(LowerBoundNode(value));
     }
 
     /** @brief Constant lower bound. */
     template <class Pick = Inorder>
     Iterator<true, Pick> lower_bound(const T& value, Pick = Inorder()) const {
-        return find(value, Pick());
+        return Iterator<true, Pick>(LowerBoundNode(value));
     }
 
-    /** @brief Returns the upper bound for a value. */
+    /**
+     * @brief Returns the upper bound for a value.
+     *
+     * For In-order this is the first element greater than the value. For the
+     * other traversals it is the element following the last equal one in
+     * that traversal order.
+     */
     template <class Pick = Inorder>
     Iterator<false, Pick> upper_bound(const T& value, Pick = Inorder()) {
-        auto it = rfind(value, Pick());
-        if (it != end(Pick())) {
-            ++it;
-        }
-        return it;
+        return Iterator<false, Pick>(UpperBoundNode(value, Pick()));
     }
 
     /** @brief Constant upper bound. */
     template <class Pick = Inorder>
     Iterator<true, Pick> upper_bound(const T& value, Pick = Inorder()) const {
-        auto it = rfind(value, Pick());
-        if (it != cend(Pick())) {
-            ++it;
+        return Iterator<true, Pick>(UpperBoundNode(value, Pick()));
+    }
+
+    /**
+     * @brief Returns a lazy view of the elements in [low, high).
+     *
+     * Both bounds are found by one O(height) descent each when the view is
+     * created; elements are only visited as the view is iterated. The view
+     * is a std::ranges::bidirectional_range and composes with std::views.
+     * It stays valid while its boundary elements are not erased.
+     * @param low Inclusive lower bound.
+     * @param high Exclusive upper bound; an empty view if not above low.
+     */
+    std::ranges::subrange<iterator> range(const T& low, const T& high) {
+        auto [first, last] = RangeOf(low, high);
+        return {iterator(first), iterator(last)};
+    }
+
+    /** @brief Constant version of range. */
+    std::ranges::subrange<const_iterator> range(const T& low, const T& high) const {
+        auto [first, last] = RangeOf(low, high);
+        return {const_iterator(first), const_iterator(last)};
+    }
+
+    /**
+     * @brief Heterogeneous lookups, available when Compare::is_transparent
+     * exists (e.g. std::less<>). They take any key comparable with T and
+     * never construct a temporary T.
+     */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    size_t count(const K& key) const {
+        return CountEqual(key);
+    }
+
+    /** @brief Heterogeneous range view. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    std::ranges::subrange<iterator> range(const K& low, const K& high) {
+        auto [first, last] = RangeOf(low, high);
+        return {iterator(first), iterator(last)};
+    }
+
+    /** @brief Constant heterogeneous range view. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    std::ranges::subrange<const_iterator> range(const K& low, const K& high) const {
+        auto [first, last] = RangeOf(low, high);
+        return {const_iterator(first), const_iterator(last)};
+    }
+
+    /** @brief Heterogeneous find. */
+    template <class K, class Pick = Inorder, class C = Compare,
+              class = typename C::is_transparent>
+    Iterator<false, Pick> find(const K& key, Pick = Inorder()) {
+        return Iterator<false, Pick>(FindNode(key));
+    }
+
+    /** @brief Constant heterogeneous find. */
+    template <class K, class Pick = Inorder, class C = Compare,
+              class = typename C::is_transparent>
+    Iterator<true, Pick> find(const K& key, Pick = Inorder()) const {
+        return Iterator<true, Pick>(FindNode(key));
+    }
+
+    /** @brief Heterogeneous contains. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    bool contains(const K& key) const {
+        return FindNode(key) != root_;
+    }
+
+    /** @brief Heterogeneous equal_range. */
+    template <class K, class Pick = Inorder, class C = Compare,
+              class = typename C::is_transparent>
+    pair<Iterator<false, Pick>, Iterator<false, Pick>> equal_range(
+        const K& key, Pick = Inorder()) {
+        return {lower_bound(key, Pick()), upper_bound(key, Pick())};
+    }
+
+    /** @brief Constant heterogeneous equal_range. */
+    template <class K, class Pick = Inorder, class C = Compare,
+              class = typename C::is_transparent>
+    pair<Iterator<true, Pick>, Iterator<true, Pick>> equal_range(
+        const K& key, Pick = Inorder()) const {
+        return {lower_bound(key, Pick()), upper_bound(key, Pick())};
+    }
+
+    /** @brief Heterogeneous lower bound. */
+    template <class K, class Pick = Inorder, class C = Compare,
+              class = typename C::is_transparent>
+    Iterator<false, Pick> lower_bound(const K& key, Pick = Inorder()) {
+        return Iterator<false, Pick>(LowerBoundNode(key));
+    }
+
+    /** @brief Constant heterogeneous lower bound. */
+    template <class K, class Pick = Inorder, class C = Compare,
+              class = typename C::is_transparent>
+    Iterator<true, Pick> lower_bound(const K& key, Pick = Inorder()) const {
+        return Iterator<true, Pick>(LowerBoundNode(key));
+    }
+
+    /** @brief Heterogeneous upper bound. */
+    template <class K, class Pick = Inorder, class C = Compare,
+              class = typename C::is_transparent>
+    Iterator<false, Pick> upper_bound(const K& key, Pick = Inorder()) {
+        return Iterator<false, Pick>(UpperBoundNode(key, Pick()));
+    }
+
+    /** @brief Constant heterogeneous upper bound. */
+    template <class K, class Pick = Inorder, class C = Compare,
+              class = typename C::is_transparent>
+    Iterator<true, Pick> upper_bound(const K& key, Pick = Inorder()) const {
+        return Iterator<true, Pick>(UpperBoundNode(key, Pick()));
+    }
+
+    /**
+     * @brief Takes an immutable, cache-friendly snapshot of the elements.
+     *
+     * The snapshot stores the elements in Eytzinger order and serves find,
+     * bounds and In-order iteration without touching this tree again.
+     * @return The snapshot, built in O(n).
+     */
+    FrozenBST<T, Compare> freeze() const {
+        return FrozenBST<T, Compare>(cbegin(), cend(), comp_);
+    }
+
+    /**
+     * @brief Writes the elements in In-order as a binary snapshot.
+     *
+     * The format is a fixed header followed by the raw elements, so T must
+     * be trivially copyable. Elements are staged through a small buffer.
+     * @throws std::runtime_error if the stream fails.
+     */
+    void save(std::ostream& out) const {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "save() requires a trivially copyable element type");
+        auto header = SnapshotHeader::Make<T>(SnapshotLayout::Sorted, size_);
+        WriteSnapshotBytes(out, &header, sizeof(header));
+        std::vector<T> chunk;
+        chunk.reserve(std::min(size_, kSnapshotChunk));
+        ScanInorder(root_->left_, [&](tree_node* node) {
+            chunk.push_back(node->data_);
+            if (chunk.size() == kSnapshotChunk) {
+                WriteSnapshotBytes(out, chunk.data(), chunk.size() * sizeof(T));
+                chunk.clear();
+            }
+        });
+        WriteSnapshotBytes(out, chunk.data(), chunk.size() * sizeof(T));
+    }
+
+    /** @brief Writes a binary snapshot to a file. */
+    void save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        save(out);
+    }
+
+    /**
+     * @brief Reads a snapshot written by save() and rebuilds it in O(n).
+     *
+     * The stored order is trusted only after checking it, so a file saved
+     * with a different comparator is rejected instead of corrupting the tree.
+     * @throws std::runtime_error on a malformed, truncated or unsorted input.
+     */
+    static BST load(std::istream& in) {
+        uint64_t count = ReadSnapshotHeader<T>(in, SnapshotLayout::Sorted);
+        BST tree;
+        tree_node* head = nullptr;
+        tree_node** tail = &head;
+        const T* prev = nullptr;
+        std::vector<T> chunk;
+        try {
+            for (uint64_t left = count; left != 0;) {
+                chunk.resize(std::min<uint64_t>(left, kSnapshotChunk));
+                ReadSnapshotBytes(in, chunk.data(), chunk.size() * sizeof(T));
+                left -= chunk.size();
+                for (const T& value : chunk) {
+                    if (prev != nullptr && tree.comp_(value, *prev)) {
+                        throw std::runtime_error("snapshot: elements are not sorted");
+                    }
+                    *tail = tree.create_node(value);
+                    prev = &(*tail)->data_;
+                    tail = &(*tail)->right_;
+                }
+            }
+        } catch (...) {
+            *tail = nullptr;
+            tree.DeleteList(head);
+            throw;
         }
-        return it;
+        *tail = nullptr;
+        tree.Rebuild(head, count);
+        return tree;
+    }
+
+    /** @brief Reads a binary snapshot file. */
+    static BST load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("snapshot: cannot open " + path);
+        }
+        return load(in);
+    }
+
+    /**
+     * @brief Calls fn on every element in In-order.
+     *
+     * A full scan without iterators: ancestors are kept on a small stack
+     * instead of being revisited through parent links, which is several
+     * times faster than an iterator loop on large trees.
+     * @param fn Callable taking const T&.
+     */
+    template <class Fn>
+    void for_each(Fn fn) const {
+        ScanInorder(root_->left_,
+                    [&](tree_node* node) { fn(std::as_const(node->data_)); });
+    }
+
+    /**
+     * @brief Calls fn on every element in In-order on the calling thread.
+     * @param fn Callable taking const T&, invoked by reference.
+     */
+    template <class Fn>
+    void parallel_for_each(Sequential, Fn&& fn) const {
+        for_each(std::ref(fn));
+    }
+
+    /**
+     * @brief Calls fn on every element, splitting the tree over threads.
+     *
+     * The tree is cut at subtree boundaries into a few pieces per thread,
+     * which workers take in order. Every piece calls the same fn through a
+     * reference, as std::for_each with std::execution::par does, so state
+     * kept in fn survives the call but fn must tolerate concurrent calls.
+     * The tree must not be modified meanwhile.
+     * @param policy Thread count.
+     * @param fn Callable taking const T&.
+     */
+    template <class Fn>
+    void parallel_for_each(Parallel policy, Fn&& fn) const {
+        size_t threads = ThreadCount(policy, size_);
+        if (threads == 1) {
+            parallel_for_each(Sequential(), fn);
+            return;
+        }
+        std::vector<SubtreeTask> tasks = SplitTasks(4 * threads);
+        RunTasks(tasks.size(), threads, [&](size_t i) { VisitTask(tasks[i], fn); });
+    }
+
+    /**
+     * @brief Folds transform(x) of every element into init, in order.
+     * @param init Initial value.
+     * @param reduce Associative binary operation on U.
+     * @param transform Maps const T& to U.
+     */
+    template <class U, class Reduce, class Transform = std::identity>
+    U parallel_reduce(Sequential, U init, Reduce reduce,
+                      Transform transform = {}) const {
+        ScanInorder(root_->left_, [&](tree_node* node) {
+            init = reduce(std::move(init), transform(std::as_const(node->data_)));
+        });
+        return init;
+    }
+
+    /**
+     * @brief Parallel transform-reduce over the elements.
+     *
+     * Each piece of the tree is reduced on its own and the partial results
+     * are combined in In-order, so reduce only needs to be associative,
+     * not commutative.
+     * @param policy Thread count.
+     * @param init Initial value.
+     * @param reduce Associative binary operation on U.
+     * @param transform Maps const T& to U.
+     */
+    template <class U, class Reduce, class Transform = std::identity>
+    U parallel_reduce(Parallel policy, U init, Reduce reduce,
+                      Transform transform = {}) const {
+        size_t threads = ThreadCount(policy, size_);
+        if (threads == 1) {
+            return parallel_reduce(Sequential(), std::move(init), reduce,
+                                   transform);
+        }
+        std::vector<SubtreeTask> tasks = SplitTasks(4 * threads);
+        std::vector<std::optional<U>> partial(tasks.size());
+        RunTasks(tasks.size(), threads, [&](size_t i) {
+            std::optional<U>& acc = partial[i];
+            auto fold = [&](const T& value) {
+                if (acc) {
+                    acc = reduce(std::move(*acc), transform(value));
+                } else {
+                    acc.emplace(transform(value));
+                }
+            };
+            VisitTask(tasks[i], fold);
+        });
+        for (std::optional<U>& acc : partial) {
+            init = reduce(std::move(init), std::move(*acc));
+        }
+        return init;
     }
 
     /** @brief Returns the comparison functor. */
@@ -931,25 +3562,29 @@ class BST {
 /**
  * @brief Non-member swap for BST.
  */
-template <class T, class Compare, class Alloc>
-void swap(BST<T, Compare, Alloc>& lhs, BST<T, Compare, Alloc>& rhs) {
+template <class T, class Compare, class Alloc, class Balance, class Augment,
+          class Stats>
+void swap(BST<T, Compare, Alloc, Balance, Augment, Stats>& lhs,
+          BST<T, Compare, Alloc, Balance, Augment, Stats>& rhs) {
     lhs.swap(rhs);
 }
 
 /**
  * @brief Non-member equality operator for BST.
  */
-template <class T, class Compare, class Alloc>
-bool operator==(const BST<T, Compare, Alloc>& lhs,
-                const BST<T, Compare, Alloc>& rhs) {
+template <class T, class Compare, class Alloc, class Balance, class Augment,
+          class Stats>
+bool operator==(const BST<T, Compare, Alloc, Balance, Augment, Stats>& lhs,
+                const BST<T, Compare, Alloc, Balance, Augment, Stats>& rhs) {
     return lhs.operator==(rhs);
 }
 
 /**
  * @brief Non-member inequality operator for BST.
  */
-template <class T, class Compare, class Alloc>
-bool operator!=(const BST<T, Compare, Alloc>& lhs,
-                const BST<T, Compare, Alloc>& rhs) {
+template <class T, class Compare, class Alloc, class Balance, class Augment,
+          class Stats>
+bool operator!=(const BST<T, Compare, Alloc, Balance, Augment, Stats>& lhs,
+                const BST<T, Compare, Alloc, Balance, Augment, Stats>& rhs) {
     return lhs.operator!=(rhs);
 }
@@ -0,0 +1,1042 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Compare.hpp"
+
+/**
+ * @brief B+ tree multiset with many keys per node and linked leaves.
+ *
+ * Every node holds as many keys as fit in about NodeBytes bytes, so a
+ * lookup touches one node per level of a very shallow tree, and the
+ * elements themselves sit in sorted arrays in the leaves, which are chained
+ * for iteration. Inner nodes only keep copies of separator keys: every key
+ * left of a separator is not greater than it, every key right of it is not
+ * less. Offers the same insert / find / bounds / erase and In-order
+ * iterator surface as BST. Like CompactBST, insert and erase invalidate
+ * all iterators, because elements shift inside their leaf.
+ * @tparam T Type of the elements (copied into separators).
+ * @tparam Compare Comparison function object type.
+ * @tparam Alloc Allocator type (rebound to the node types).
+ * @tparam NodeBytes Target size of one node in bytes.
+ */
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>,
+          size_t NodeBytes = 256>
+class BTreeBST {
+   private:
+
+    /** @brief Number of slots of a given size fitting next to a header. */
+    static constexpr size_t Slots(size_t header, size_t slot) {
+        return NodeBytes > header + 4 * slot ? (NodeBytes - header) / slot : 4;
+    }
+
+    /** @brief Keys per leaf (leaf header: parent, prev, next, count). */
+    static constexpr size_t kLeafSlots = Slots(4 * sizeof(void*), sizeof(T));
+    /** @brief Separators per inner node; it has one child more. */
+    static constexpr size_t kInnerSlots =
+        Slots(3 * sizeof(void*), sizeof(T) + sizeof(void*));
+    /**
+     * @brief Fewest keys a non-root leaf keeps.
+     *
+     * The last leaf is exempt: Append() starts it with a single key.
+     */
+    static constexpr size_t kLeafMin = kLeafSlots / 2;
+    /** @brief Fewest separators a non-root inner node keeps. */
+    static constexpr size_t kInnerMin = (kInnerSlots - 1) / 2;
+    /** @brief Height bound: every inner level at least doubles the leaves. */
+    static constexpr size_t kMaxHeight = 8 * sizeof(size_t);
+
+    static_assert(kInnerSlots <= std::numeric_limits<uint16_t>::max() &&
+                      kLeafSlots <= std::numeric_limits<uint16_t>::max(),
+                  "NodeBytes too large for 16-bit slot counts");
+
+    struct InnerNode;
+
+    /** @brief Fields shared by leaves and inner nodes. */
+    struct BTreeNode {
+        InnerNode* parent_ = nullptr;
+        uint16_t count_ = 0;
+    };
+
+    /** @brief Uninitialised storage for N keys; [0, count_) are alive. */
+    template <size_t N>
+    struct KeySlots {
+        alignas(T) unsigned char bytes_[N * sizeof(T)];
+
+        T* data() { return std::launder(reinterpret_cast<T*>(bytes_)); }
+        const T* data() const {
+            return std::launder(reinterpret_cast<const T*>(bytes_));
+        }
+    };
+
+    /** @brief Leaf: sorted elements, chained to its neighbours. */
+    struct LeafNode : BTreeNode {
+        LeafNode* prev_ = nullptr;
+        LeafNode* next_ = nullptr;
+        KeySlots<kLeafSlots> keys_;
+    };
+
+    /** @brief Inner node: count_ separators between count_ + 1 children. */
+    struct InnerNode : BTreeNode {
+        KeySlots<kInnerSlots> keys_;
+        BTreeNode* children_[kInnerSlots + 1];
+    };
+
+    using leaf_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<LeafNode>;
+    using inner_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<InnerNode>;
+    using leaf_traits = std::allocator_traits<leaf_allocator_type>;
+    using inner_traits = std::allocator_traits<inner_allocator_type>;
+
+    /**
+     * @brief Bidirectional In-order iterator over the elements.
+     *
+     * Holds the tree, a leaf and a slot in it; elements are read-only
+     * because changing a key would break the ordering.
+     */
+    class Iterator {
+        friend class BTreeBST;
+
+       private:
+        const BTreeBST* tree_;
+        const LeafNode* leaf_;
+        size_t slot_;
+
+        Iterator(const BTreeBST* tree, const LeafNode* leaf, size_t slot)
+            : tree_(tree), leaf_(leaf), slot_(slot) {}
+
+       public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator() : tree_(nullptr), leaf_(nullptr), slot_(0) {}
+
+        /** @brief Dereference operator to access the element. */
+        reference operator*() const { return leaf_->keys_.data()[slot_]; }
+
+        /** @brief Member access to the element. */
+        pointer operator->() const { return leaf_->keys_.data() + slot_; }
+
+        /** @brief Pre-increment operator. */
+        Iterator& operator++() {
+            if (++slot_ == leaf_->count_) {
+                leaf_ = leaf_->next_;
+                slot_ = 0;
+            }
+            return *this;
+        }
+
+        /** @brief Pre-decrement operator; end() steps to the last element. */
+        Iterator& operator--() {
+            if (leaf_ == nullptr) {
+                leaf_ = tree_->last_;
+                slot_ = leaf_->count_ - 1;
+            } else if (slot_ == 0) {
+                leaf_ = leaf_->prev_;
+                slot_ = leaf_->count_ - 1;
+            } else {
+                --slot_;
+            }
+            return *this;
+        }
+
+        /** @brief Post-increment operator. */
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        /** @brief Post-decrement operator. */
+        Iterator operator--(int) {
+            Iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        /** @brief Equality comparison. */
+        bool operator==(const Iterator& other) const {
+            return leaf_ == other.leaf_ && slot_ == other.slot_;
+        }
+
+        /** @brief Inequality comparison. */
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    leaf_allocator_type leaf_alloc_;
+    inner_allocator_type inner_alloc_;
+    Compare comp_;
+    BTreeNode* root_ = nullptr;
+    LeafNode* first_ = nullptr;
+    LeafNode* last_ = nullptr;
+    size_t height_ = 0;
+    size_t size_ = 0;
+
+    /** @brief Inserts a key at a slot of a sorted array of count keys. */
+    template <class V>
+    static void InsertKey(T* keys, size_t count, size_t slot, V&& value) {
+        if (slot == count) {
+            ::new (static_cast<void*>(keys + count)) T(std::forward<V>(value));
+            return;
+        }
+        ::new (static_cast<void*>(keys + count)) T(std::move(keys[count - 1]));
+        std::move_backward(keys + slot, keys + count - 1, keys + count);
+        keys[slot] = std::forward<V>(value);
+    }
+
+    /** @brief Removes the key at a slot of an array of count keys. */
+    static void EraseKey(T* keys, size_t count, size_t slot) {
+        std::move(keys + slot + 1, keys + count, keys + slot);
+        std::destroy_at(keys + count - 1);
+    }
+
+    /** @brief Moves count keys into uninitialised slots. */
+    static void MoveKeys(T* from, size_t count, T* to) {
+        std::uninitialized_move(from, from + count, to);
+        std::destroy(from, from + count);
+    }
+
+    /** @brief Allocates an empty leaf. */
+    LeafNode* NewLeaf() {
+        LeafNode* leaf = leaf_traits::allocate(leaf_alloc_, 1);
+        return ::new (static_cast<void*>(leaf)) LeafNode;
+    }
+
+    /** @brief Allocates an empty inner node. */
+    InnerNode* NewInner() {
+        InnerNode* inner = inner_traits::allocate(inner_alloc_, 1);
+        return ::new (static_cast<void*>(inner)) InnerNode;
+    }
+
+    /** @brief Destroys the keys of a leaf and frees it. */
+    void DeleteLeaf(LeafNode* leaf) {
+        std::destroy(leaf->keys_.data(), leaf->keys_.data() + leaf->count_);
+        leaf->~LeafNode();
+        leaf_traits::deallocate(leaf_alloc_, leaf, 1);
+    }
+
+    /** @brief Destroys the separators of an inner node and frees it. */
+    void DeleteInner(InnerNode* inner) {
+        std::destroy(inner->keys_.data(), inner->keys_.data() + inner->count_);
+        inner->~InnerNode();
+        inner_traits::deallocate(inner_alloc_, inner, 1);
+    }
+
+    /**
+     * @brief Inner nodes allocated before a leaf split, one for every level
+     * the split can climb, so that linking it in cannot fail halfway.
+     *
+     * Unused nodes are freed on destruction.
+     */
+    class SpareInners {
+       private:
+        BTreeBST& tree_;
+        InnerNode* nodes_[kMaxHeight];
+        size_t count_ = 0;
+
+        /** @brief Frees the nodes not taken. */
+        void Release() {
+            while (count_ > 0) {
+                tree_.DeleteInner(nodes_[--count_]);
+            }
+        }
+
+       public:
+        /**
+         * @brief Allocates a node per full ancestor of the leaf, plus one for
+         * a new root when the chain of splits reaches the root.
+         */
+        SpareInners(BTreeBST& tree, const BTreeNode* leaf) : tree_(tree) {
+            try {
+                for (const BTreeNode* node = leaf;; node = node->parent_) {
+                    if (node != tree_.root_ && node->parent_->count_ < kInnerSlots) {
+                        break;
+                    }
+                    nodes_[count_] = tree_.NewInner();
+                    ++count_;
+                    if (node == tree_.root_) {
+                        break;
+                    }
+                }
+            } catch (...) {
+                Release();
+                throw;
+            }
+        }
+
+        SpareInners(const SpareInners&) = delete;
+        SpareInners& operator=(const SpareInners&) = delete;
+
+        ~SpareInners() { Release(); }
+
+        /** @brief Hands out one of the nodes. */
+        InnerNode* Take() { return nodes_[--count_]; }
+    };
+
+    /**
+     * @brief Frees a subtree.
+     * @param depth Number of levels in the subtree (1 for a leaf).
+     */
+    void DeleteTree(BTreeNode* node, size_t depth) {
+        if (depth == 1) {
+            DeleteLeaf(static_cast<LeafNode*>(node));
+            return;
+        }
+        auto* inner = static_cast<InnerNode*>(node);
+        for (size_t i = 0; i <= inner->count_; ++i) {
+            DeleteTree(inner->children_[i], depth - 1);
+        }
+        DeleteInner(inner);
+    }
+
+    /** @brief Returns the position of a child among its parent's children. */
+    static size_t ChildIndex(const InnerNode* parent, const BTreeNode* child) {
+        size_t index = 0;
+        while (parent->children_[index] != child) {
+            ++index;
+        }
+        return index;
+    }
+
+    /**
+     * @brief Counts the keys ordered before a value in a sorted array.
+     * @tparam Upper Counts keys not greater than the value if true, keys
+     * less than it otherwise.
+     */
+    template <bool Upper, class K>
+    size_t Rank(const T* keys, size_t count, const K& value) const {
+        if constexpr (kArithmeticLess<T, Compare> && std::is_same_v<K, T>) {
+            // Branch-free linear count; the compiler vectorises it.
+            size_t rank = 0;
+            for (size_t i = 0; i < count; ++i) {
+                rank += Upper ? !(value < keys[i]) : keys[i] < value;
+            }
+            return rank;
+        } else if constexpr (Upper) {
+            return std::upper_bound(keys, keys + count, value, comp_) - keys;
+        } else {
+            return std::lower_bound(keys, keys + count, value, comp_) - keys;
+        }
+    }
+
+    /**
+     * @brief Descends to the leaf slot of the lower (or upper) bound.
+     * @return The leaf and slot; the slot may equal the leaf's count, in
+     * which case the bound is the first element of the next leaf.
+     */
+    template <bool Upper, class K>
+    std::pair<LeafNode*, size_t> Search(const K& value) const {
+        BTreeNode* node = root_;
+        for (size_t level = 1; level < height_; ++level) {
+            auto* inner = static_cast<InnerNode*>(node);
+            node = inner->children_[Rank<Upper>(inner->keys_.data(),
+                                                inner->count_, value)];
+        }
+        auto* leaf = static_cast<LeafNode*>(node);
+        return {leaf, Rank<Upper>(leaf->keys_.data(), leaf->count_, value)};
+    }
+
+    /** @brief Turns a leaf slot into an iterator, moving past a full leaf. */
+    Iterator MakeIterator(const LeafNode* leaf, size_t slot) const {
+        if (leaf != nullptr && slot == leaf->count_) {
+            return Iterator(this, leaf->next_, 0);
+        }
+        return Iterator(this, leaf, slot);
+    }
+
+    /** @brief Returns an iterator to the lower bound of a value. */
+    template <class K>
+    Iterator LowerBound(const K& value) const {
+        if (root_ == nullptr) {
+            return end();
+        }
+        auto [leaf, slot] = Search<false>(value);
+        return MakeIterator(leaf, slot);
+    }
+
+    /** @brief Returns an iterator to the upper bound of a value. */
+    template <class K>
+    Iterator UpperBound(const K& value) const {
+        if (root_ == nullptr) {
+            return end();
+        }
+        auto [leaf, slot] = Search<true>(value);
+        return MakeIterator(leaf, slot);
+    }
+
+    /** @brief Returns an iterator to the first element equal to the value. */
+    template <class K>
+    Iterator Find(const K& value) const {
+        Iterator it = LowerBound(value);
+        if (it.leaf_ != nullptr && comp_(value, *it)) {
+            return end();
+        }
+        return it;
+    }
+
+    /** @brief Links a new leaf into the chain right after another one. */
+    void LinkLeafAfter(LeafNode* leaf, LeafNode* next) {
+        next->prev_ = leaf;
+        next->next_ = leaf->next_;
+        if (leaf->next_ != nullptr) {
+            leaf->next_->prev_ = next;
+        } else {
+            last_ = next;
+        }
+        leaf->next_ = next;
+    }
+
+    /** @brief Removes a leaf from the chain. */
+    void UnlinkLeaf(LeafNode* leaf) {
+        (leaf->prev_ != nullptr ? leaf->prev_->next_ : first_) = leaf->next_;
+        (leaf->next_ != nullptr ? leaf->next_->prev_ : last_) = leaf->prev_;
+    }
+
+    /**
+     * @brief Splits a full inner node around its middle separator.
+     *
+     * The middle separator moves up into the parent, which may split in turn.
+     * @param index Child position about to receive a new sibling.
+     * @param spares Nodes for this split and those above it.
+     * @return The half holding that child and the child's position in it.
+     */
+    std::pair<InnerNode*, size_t> SplitInner(InnerNode* node, size_t index,
+                                             SpareInners& spares) {
+        constexpr size_t mid = kInnerSlots / 2;
+        InnerNode* right = spares.Take();
+        T* keys = node->keys_.data();
+        MoveKeys(keys + mid + 1, kInnerSlots - mid - 1, right->keys_.data());
+        for (size_t i = mid + 1; i <= kInnerSlots; ++i) {
+            right->children_[i - mid - 1] = node->children_[i];
+            node->children_[i]->parent_ = right;
+        }
+        right->count_ = kInnerSlots - mid - 1;
+        T up(std::move(keys[mid]));
+        std::destroy_at(keys + mid);
+        node->count_ = mid;
+        InsertIntoParent(node, std::move(up), right, spares);
+        if (index <= mid) {
+            return {node, index};
+        }
+        return {right, index - mid - 1};
+    }
+
+    /**
+     * @brief Adds a new right sibling and its separator above a node.
+     *
+     * Grows a new root when the node is the root. Only moves keys, so it
+     * cannot throw once the spares are allocated.
+     */
+    void InsertIntoParent(BTreeNode* left, T&& separator, BTreeNode* right,
+                          SpareInners& spares) {
+        if (left == root_) {
+            InnerNode* root = spares.Take();
+            ::new (static_cast<void*>(root->keys_.data())) T(std::move(separator));
+            root->count_ = 1;
+            root->children_[0] = left;
+            root->children_[1] = right;
+            left->parent_ = right->parent_ = root;
+            root_ = root;
+            ++height_;
+            return;
+        }
+        InnerNode* parent = left->parent_;
+        size_t index = ChildIndex(parent, left);
+        if (parent->count_ == kInnerSlots) {
+            std::tie(parent, index) = SplitInner(parent, index, spares);
+        }
+        InsertKey(parent->keys_.data(), parent->count_, index, std::move(separator));
+        std::copy_backward(parent->children_ + index + 1,
+                           parent->children_ + parent->count_ + 1,
+                           parent->children_ + parent->count_ + 2);
+        parent->children_[index + 1] = right;
+        right->parent_ = parent;
+        ++parent->count_;
+    }
+
+    /**
+     * @brief Splits a full leaf in two halves before an insertion.
+     *
+     * The separator copy and every node the split needs are made before
+     * the tree changes, so a throw leaves it untouched.
+     * @param slot Slot the new element goes to.
+     * @return The half receiving the element and its slot there.
+     */
+    std::pair<LeafNode*, size_t> SplitLeaf(LeafNode* leaf, size_t slot) {
+        constexpr size_t half = kLeafSlots / 2;
+        // Elements up to the old keys[half] stay left, so the separator
+        // remains the smallest key on the right.
+        T separator(std::as_const(leaf->keys_.data()[half]));
+        SpareInners spares(*this, leaf);
+        LeafNode* right = NewLeaf();
+        MoveKeys(leaf->keys_.data() + half, kLeafSlots - half, right->keys_.data());
+        right->count_ = kLeafSlots - half;
+        leaf->count_ = half;
+        LinkLeafAfter(leaf, right);
+        InsertIntoParent(leaf, std::move(separator), right, spares);
+        if (slot <= half) {
+            return {leaf, slot};
+        }
+        return {right, slot - half};
+    }
+
+    /**
+     * @brief Adds an element not less than any other at the end.
+     *
+     * A full last leaf is not split but followed by a fresh one, so sorted
+     * input fills leaves completely. That fresh leaf starts below kLeafMin;
+     * EraseAt() lets the last leaf stay under-full.
+     */
+    Iterator Append(T&& value) {
+        LeafNode* leaf = last_;
+        if (leaf->count_ == kLeafSlots) {
+            T separator(std::as_const(value));
+            SpareInners spares(*this, leaf);
+            LeafNode* next = NewLeaf();
+            ::new (static_cast<void*>(next->keys_.data())) T(std::move(value));
+            next->count_ = 1;
+            LinkLeafAfter(leaf, next);
+            InsertIntoParent(leaf, std::move(separator), next, spares);
+            ++size_;
+            return Iterator(this, next, 0);
+        }
+        ::new (static_cast<void*>(leaf->keys_.data() + leaf->count_)) T(std::move(value));
+        ++size_;
+        return Iterator(this, leaf, leaf->count_++);
+    }
+
+    /**
+     * @brief Restores the minimum fill of an inner node after a removal,
+     * borrowing from or merging with a sibling.
+     */
+    void RebalanceInner(InnerNode* node) {
+        if (node == root_) {
+            if (node->count_ == 0) {
+                root_ = node->children_[0];
+                root_->parent_ = nullptr;
+                DeleteInner(node);
+                --height_;
+            }
+            return;
+        }
+        if (node->count_ >= kInnerMin) {
+            return;
+        }
+        InnerNode* parent = node->parent_;
+        size_t index = ChildIndex(parent, node);
+        T* separators = parent->keys_.data();
+        if (index > 0) {
+            auto* left = static_cast<InnerNode*>(parent->children_[index - 1]);
+            if (left->count_ > kInnerMin) {
+                // Rotate right through the parent separator.
+                InsertKey(node->keys_.data(), node->count_, 0,
+                          std::move(separators[index - 1]));
+                separators[index - 1] = std::move(left->keys_.data()[left->count_ - 1]);
+                std::destroy_at(left->keys_.data() + left->count_ - 1);
+                std::copy_backward(node->children_, node->children_ + node->count_ + 1,
+                                   node->children_ + node->count_ + 2);
+                node->children_[0] = left->children_[left->count_];
+                node->children_[0]->parent_ = node;
+                --left->count_;
+                ++node->count_;
+                return;
+            }
+            MergeInner(left, index - 1, node);
+            return;
+        }
+        auto* right = static_cast<InnerNode*>(parent->children_[index + 1]);
+        if (right->count_ > kInnerMin) {
+            // Rotate left through the parent separator.
+            ::new (static_cast<void*>(node->keys_.data() + node->count_))
+                T(std::move(separators[index]));
+            separators[index] = std::move(right->keys_.data()[0]);
+            EraseKey(right->keys_.data(), right->count_, 0);
+            node->children_[node->count_ + 1] = right->children_[0];
+            node->children_[node->count_ + 1]->parent_ = node;
+            std::copy(right->children_ + 1, right->children_ + right->count_ + 1,
+                      right->children_);
+            ++node->count_;
+            --right->count_;
+            return;
+        }
+        MergeInner(node, index, right);
+    }
+
+    /**
+     * @brief Merges an inner node into its left sibling, pulling down the
+     * separator between them, then rebalances the parent.
+     * @param separator Position of that separator in the parent.
+     */
+    void MergeInner(InnerNode* left, size_t separator, InnerNode* right) {
+        InnerNode* parent = left->parent_;
+        T* keys = left->keys_.data();
+        ::new (static_cast<void*>(keys + left->count_))
+            T(std::move(parent->keys_.data()[separator]));
+        MoveKeys(right->keys_.data(), right->count_, keys + left->count_ + 1);
+        for (size_t i = 0; i <= right->count_; ++i) {
+            left->children_[left->count_ + 1 + i] = right->children_[i];
+            right->children_[i]->parent_ = left;
+        }
+        left->count_ += right->count_ + 1;
+        right->count_ = 0;
+        RemoveChild(parent, separator);
+        DeleteInner(right);
+        RebalanceInner(parent);
+    }
+
+    /** @brief Removes a separator and the child to its right. */
+    static void RemoveChild(InnerNode* parent, size_t separator) {
+        EraseKey(parent->keys_.data(), parent->count_, separator);
+        std::copy(parent->children_ + separator + 2,
+                  parent->children_ + parent->count_ + 1,
+                  parent->children_ + separator + 1);
+        --parent->count_;
+    }
+
+    /**
+     * @brief Restores the minimum fill of a leaf after an erase.
+     * @param slot Slot of the element following the erased one.
+     * @return Where that element is once the leaves are rebalanced.
+     */
+    std::pair<LeafNode*, size_t> RebalanceLeaf(LeafNode* leaf, size_t slot) {
+        InnerNode* parent = leaf->parent_;
+        size_t index = ChildIndex(parent, leaf);
+        T* separators = parent->keys_.data();
+        T* keys = leaf->keys_.data();
+        if (index > 0) {
+            auto* left = static_cast<LeafNode*>(parent->children_[index - 1]);
+            T* left_keys = left->keys_.data();
+            if (left->count_ > kLeafMin) {
+                InsertKey(keys, leaf->count_, 0, std::move(left_keys[left->count_ - 1]));
+                std::destroy_at(left_keys + left->count_ - 1);
+                --left->count_;
+                ++leaf->count_;
+                separators[index - 1] = keys[0];
+                return {leaf, slot + 1};
+            }
+            size_t offset = left->count_;
+            MoveKeys(keys, leaf->count_, left_keys + offset);
+            left->count_ += leaf->count_;
+            leaf->count_ = 0;
+            UnlinkLeaf(leaf);
+            RemoveChild(parent, index - 1);
+            DeleteLeaf(leaf);
+            RebalanceInner(parent);
+            return {left, offset + slot};
+        }
+        auto* right = static_cast<LeafNode*>(parent->children_[index + 1]);
+        T* right_keys = right->keys_.data();
+        if (right->count_ > kLeafMin) {
+            ::new (static_cast<void*>(keys + leaf->count_)) T(std::move(right_keys[0]));
+            EraseKey(right_keys, right->count_, 0);
+            --right->count_;
+            ++leaf->count_;
+            separators[index] = right_keys[0];
+            return {leaf, slot};
+        }
+        MoveKeys(right_keys, right->count_, keys + leaf->count_);
+        leaf->count_ += right->count_;
+        right->count_ = 0;
+        UnlinkLeaf(right);
+        RemoveChild(parent, index);
+        DeleteLeaf(right);
+        RebalanceInner(parent);
+        return {leaf, slot};
+    }
+
+    /**
+     * @brief Erases the element at a leaf slot.
+     * @return Iterator to the following element.
+     */
+    Iterator EraseAt(LeafNode* leaf, size_t slot) {
+        EraseKey(leaf->keys_.data(), leaf->count_, slot);
+        --leaf->count_;
+        --size_;
+        if (leaf == root_) {
+            if (leaf->count_ == 0) {
+                DeleteLeaf(leaf);
+                root_ = first_ = last_ = nullptr;
+                height_ = 0;
+                return end();
+            }
+        } else if (leaf->count_ < kLeafMin && (leaf != last_ || leaf->count_ == 0)) {
+            // The last leaf may run under-full (see Append()); it is the
+            // rightmost child, so it always has a left sibling to merge into.
+            std::tie(leaf, slot) = RebalanceLeaf(leaf, slot);
+        }
+        return MakeIterator(leaf, slot);
+    }
+
+    /**
+     * @brief Fills this empty tree with the elements of another, in full
+     * leaves: copied from a const tree, otherwise moved out of it. Leaves
+     * this tree empty if it throws.
+     */
+    template <class Source>
+    void AppendFrom(Source& other) {
+        if (other.empty()) {
+            return;
+        }
+        root_ = first_ = last_ = NewLeaf();
+        height_ = 1;
+        try {
+            for (LeafNode* leaf = other.first_; leaf != nullptr; leaf = leaf->next_) {
+                T* keys = leaf->keys_.data();
+                for (size_t i = 0; i < leaf->count_; ++i) {
+                    if constexpr (std::is_const_v<Source>) {
+                        Append(T(std::as_const(keys[i])));
+                    } else {
+                        Append(std::move(keys[i]));
+                    }
+                }
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    /** @brief Takes over the nodes of another tree, leaving it empty. */
+    void StealNodes(BTreeBST& other) noexcept {
+        root_ = std::exchange(other.root_, nullptr);
+        first_ = std::exchange(other.first_, nullptr);
+        last_ = std::exchange(other.last_, nullptr);
+        height_ = std::exchange(other.height_, 0);
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    /**
+     * @brief Move assignment when the nodes can change owner: the allocator
+     * propagates or both allocators are equal.
+     */
+    void MoveAssign(BTreeBST& other, std::true_type) noexcept(
+        std::is_nothrow_move_assignable_v<Compare>) {
+        clear();
+        if constexpr (leaf_traits::propagate_on_container_move_assignment::value) {
+            leaf_alloc_ = std::move(other.leaf_alloc_);
+            inner_alloc_ = std::move(other.inner_alloc_);
+        }
+        comp_ = std::move(other.comp_);
+        StealNodes(other);
+    }
+
+    /**
+     * @brief Move assignment when the allocators may differ: nodes are only
+     * stolen from an equal allocator, otherwise elements are moved one by one
+     * into nodes of this allocator.
+     */
+    void MoveAssign(BTreeBST& other, std::false_type) {
+        if (leaf_alloc_ == other.leaf_alloc_) {
+            MoveAssign(other, std::true_type());
+            return;
+        }
+        clear();
+        comp_ = other.comp_;
+        AppendFrom(other);
+        other.clear();
+    }
+
+   public:
+    using value_type = T;
+    using key_type = T;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using allocator_type = Alloc;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    /** @brief Default constructor. Creates an empty tree. */
+    BTreeBST() : BTreeBST(Compare()) {}
+
+    /** @brief Creates an empty tree with a comparator and allocator. */
+    explicit BTreeBST(const Compare& comp, const Alloc& alloc = Alloc())
+        : leaf_alloc_(alloc), inner_alloc_(alloc), comp_(comp) {}
+
+    /** @brief Constructs a tree from a range of elements. */
+    template <class InputIt>
+    BTreeBST(InputIt first, InputIt last) : BTreeBST() {
+        insert(first, last);
+    }
+
+    /** @brief Constructs a tree from an initializer list. */
+    BTreeBST(std::initializer_list<T> il) : BTreeBST() {
+        insert(il.begin(), il.end());
+    }
+
+    /** @brief Copy constructor; the copy is built with full leaves. */
+    BTreeBST(const BTreeBST& other)
+        : leaf_alloc_(leaf_traits::select_on_container_copy_construction(
+              other.leaf_alloc_)),
+          inner_alloc_(leaf_alloc_),
+          comp_(other.comp_) {
+        AppendFrom(other);
+    }
+
+    /** @brief Move constructor. Takes over the nodes in O(1). */
+    BTreeBST(BTreeBST&& other) noexcept(std::is_nothrow_copy_constructible_v<Compare>)
+        : leaf_alloc_(std::move(other.leaf_alloc_)),
+          inner_alloc_(leaf_alloc_),
+          comp_(other.comp_),
+          root_(std::exchange(other.root_, nullptr)),
+          first_(std::exchange(other.first_, nullptr)),
+          last_(std::exchange(other.last_, nullptr)),
+          height_(std::exchange(other.height_, 0)),
+          size_(std::exchange(other.size_, 0)) {}
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * The copy is built with the allocator this tree ends up with, so that
+     * moving it in never needs unequal allocators to swap nodes.
+     */
+    BTreeBST& operator=(const BTreeBST& other) {
+        if (this != &other) {
+            BTreeBST copy(other.comp_,
+                          leaf_traits::propagate_on_container_copy_assignment::value
+                              ? Alloc(other.leaf_alloc_)
+                              : Alloc(leaf_alloc_));
+            copy.AppendFrom(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * O(1) when the allocator propagates or compares equal; otherwise the
+     * elements are moved into nodes of this tree's allocator.
+     */
+    BTreeBST& operator=(BTreeBST&& other) noexcept(
+        (leaf_traits::propagate_on_container_move_assignment::value ||
+         leaf_traits::is_always_equal::value) &&
+        std::is_nothrow_move_assignable_v<Compare>) {
+        if (this != &other) {
+            MoveAssign(other,
+                       std::bool_constant<
+                           leaf_traits::propagate_on_container_move_assignment::value ||
+                           leaf_traits::is_always_equal::value>());
+        }
+        return *this;
+    }
+
+    /** @brief Destructor. Frees every node. */
+    ~BTreeBST() { clear(); }
+
+    /** @brief Returns an iterator to the smallest element. */
+    Iterator begin() const { return Iterator(this, first_, 0); }
+
+    /** @brief Returns the past-the-end iterator. */
+    Iterator end() const { return Iterator(this, nullptr, 0); }
+
+    /** @brief Returns a constant iterator to the smallest element. */
+    Iterator cbegin() const { return begin(); }
+
+    /** @brief Returns the constant past-the-end iterator. */
+    Iterator cend() const { return end(); }
+
+    /** @brief Checks if the tree is empty. */
+    bool empty() const { return size_ == 0; }
+
+    /** @brief Returns the number of elements. */
+    size_t size() const { return size_; }
+
+    /** @brief Returns the theoretical maximum number of elements. */
+    size_t max_size() const {
+        return std::numeric_limits<size_t>::max() / sizeof(LeafNode) * kLeafMin;
+    }
+
+    /** @brief Returns the number of node levels (0 when empty). */
+    size_t height() const { return height_; }
+
+    /** @brief Removes all elements. */
+    void clear() {
+        if (root_ != nullptr) {
+            DeleteTree(root_, height_);
+        }
+        root_ = first_ = last_ = nullptr;
+        height_ = size_ = 0;
+    }
+
+    /** @brief Swaps contents with another tree. */
+    void swap(BTreeBST& other) noexcept {
+        using std::swap;
+        if constexpr (leaf_traits::propagate_on_container_swap::value) {
+            swap(leaf_alloc_, other.leaf_alloc_);
+            swap(inner_alloc_, other.inner_alloc_);
+        }
+        swap(comp_, other.comp_);
+        swap(root_, other.root_);
+        swap(first_, other.first_);
+        swap(last_, other.last_);
+        swap(height_, other.height_);
+        swap(size_, other.size_);
+    }
+
+    /**
+     * @brief Constructs an element and inserts it at its upper-bound position.
+     *
+     * An element not less than the current maximum is appended to the last
+     * leaf directly, so sorted input skips the descent.
+     * @return Iterator to the new element.
+     */
+    template <class... Args>
+    Iterator emplace(Args&&... args) {
+        T value(std::forward<Args>(args)...);
+        if (root_ == nullptr) {
+            root_ = first_ = last_ = NewLeaf();
+            height_ = 1;
+        }
+        if (last_->count_ == 0 ||
+            !comp_(value, last_->keys_.data()[last_->count_ - 1])) {
+            return Append(std::move(value));
+        }
+        auto [leaf, slot] = Search<true>(value);
+        if (leaf->count_ == kLeafSlots) {
+            std::tie(leaf, slot) = SplitLeaf(leaf, slot);
+        }
+        InsertKey(leaf->keys_.data(), leaf->count_, slot, std::move(value));
+        ++leaf->count_;
+        ++size_;
+        return Iterator(this, leaf, slot);
+    }
+
+    /** @brief Inserts a copy of the value. */
+    Iterator insert(const T& value) { return emplace(value); }
+
+    /** @brief Inserts the value by moving it. */
+    Iterator insert(T&& value) { return emplace(std::move(value)); }
+
+    /** @brief Inserts elements from a range. */
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            emplace(*first);
+        }
+    }
+
+    /** @brief Inserts elements from an initializer list. */
+    void insert(std::initializer_list<T> il) { insert(il.begin(), il.end()); }
+
+    /**
+     * @brief Erases the element at an iterator.
+     * @return Iterator to the next element.
+     */
+    Iterator erase(Iterator it) {
+        if (it.leaf_ == nullptr) {
+            return it;
+        }
+        return EraseAt(const_cast<LeafNode*>(it.leaf_), it.slot_);
+    }
+
+    /**
+     * @brief Erases every element equal to the value.
+     * @return The number of elements removed.
+     */
+    size_t erase(const T& value) {
+        size_t count = 0;
+        for (Iterator it = LowerBound(value);
+             it.leaf_ != nullptr && !comp_(value, *it); ++count) {
+            it = erase(it);
+        }
+        return count;
+    }
+
+    /** @brief Returns an iterator to the first element equal to the value. */
+    Iterator find(const T& value) const { return Find(value); }
+
+    /** @brief Heterogeneous find for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator find(const K& key) const {
+        return Find(key);
+    }
+
+    /** @brief Checks whether an element equal to the value exists. */
+    bool contains(const T& value) const { return Find(value) != end(); }
+
+    /** @brief Heterogeneous contains for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    bool contains(const K& key) const {
+        return Find(key) != end();
+    }
+
+    /** @brief Returns the number of elements equal to the value. */
+    size_t count(const T& value) const {
+        size_t count = 0;
+        for (Iterator it = LowerBound(value);
+             it.leaf_ != nullptr && !comp_(value, *it); ++it) {
+            ++count;
+        }
+        return count;
+    }
+
+    /** @brief Returns an iterator to the first element not less than the value. */
+    Iterator lower_bound(const T& value) const { return LowerBound(value); }
+
+    /** @brief Heterogeneous lower_bound for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator lower_bound(const K& key) const {
+        return LowerBound(key);
+    }
+
+    /** @brief Returns an iterator to the first element greater than the value. */
+    Iterator upper_bound(const T& value) const { return UpperBound(value); }
+
+    /** @brief Heterogeneous upper_bound for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator upper_bound(const K& key) const {
+        return UpperBound(key);
+    }
+
+    /** @brief Returns the range of elements equal to the value. */
+    std::pair<Iterator, Iterator> equal_range(const T& value) const {
+        return {lower_bound(value), upper_bound(value)};
+    }
+
+    /** @brief Returns the comparison object. */
+    Compare key_comp() const { return comp_; }
+
+    /** @brief Returns the comparison object. */
+    Compare value_comp() const { return comp_; }
+
+    /** @brief Returns the allocator. */
+    Alloc get_allocator() const { return Alloc(leaf_alloc_); }
+
+    /** @brief Returns the number of bytes taken by one leaf. */
+    static constexpr size_t node_size() { return sizeof(LeafNode); }
+
+    /** @brief Returns the number of elements one leaf holds. */
+    static constexpr size_t leaf_capacity() { return kLeafSlots; }
+
+    /** @brief Checks whether two trees hold the same sequence of elements. */
+    bool operator==(const BTreeBST& other) const {
+        return size() == other.size() &&
+               std::equal(begin(), end(), other.begin());
+    }
+
+    /** @brief Checks whether two trees differ. */
+    bool operator!=(const BTreeBST& other) const { return !(*this == other); }
+};
+
+/** @brief Swaps the contents of two B+ trees. */
+template <class T, class Compare, class Alloc, size_t NodeBytes>
+void swap(BTreeBST<T, Compare, Alloc, NodeBytes>& lhs,
+          BTreeBST<T, Compare, Alloc, NodeBytes>& rhs) noexcept {
+    lhs.swap(rhs);
+}
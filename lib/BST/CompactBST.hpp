@@ -0,0 +1,764 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Compare.hpp"
+
+/**
+ * @brief Red-black multiset whose nodes live in one contiguous vector and
+ * link to each other by 32-bit indices.
+ *
+ * Each node holds the value and three uint32_t links, with the colour packed
+ * into the top bit of the parent link, so a CompactBST<int> node takes 16
+ * bytes against 32-40 for BST<int>. Storage is kept dense: erase moves the
+ * last node into the freed slot, so the tree can be copied or relocated as
+ * a plain vector. The price is vector-like iterator invalidation: insert and
+ * erase invalidate all iterators.
+ * @tparam T Type of the elements.
+ * @tparam Compare Comparison function object type.
+ * @tparam Alloc Allocator type (rebound to the node type).
+ */
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+class CompactBST {
+   private:
+    /** @brief Index value meaning "no node"; also the end() position. */
+    static constexpr uint32_t kNil = 0x7FFFFFFF;
+    /** @brief Bit of the parent link that stores the red colour. */
+    static constexpr uint32_t kRedBit = 0x80000000;
+
+    /** @brief Tree node: the value plus index links. */
+    struct CompactNode {
+        T data_;
+        uint32_t left_ = kNil;
+        uint32_t right_ = kNil;
+        uint32_t parent_ = kNil;
+
+        template <class... Args>
+        explicit CompactNode(std::in_place_t, Args&&... args)
+            : data_(std::forward<Args>(args)...) {}
+    };
+
+    using node_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<CompactNode>;
+
+    /**
+     * @brief Bidirectional In-order iterator over the elements.
+     *
+     * Holds the tree and a node index; elements are read-only because
+     * changing a key would break the ordering.
+     */
+    class Iterator {
+        friend class CompactBST;
+
+       private:
+        const CompactBST* tree_;
+        uint32_t index_;
+
+        Iterator(const CompactBST* tree, uint32_t index)
+            : tree_(tree), index_(index) {}
+
+       public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator() : tree_(nullptr), index_(kNil) {}
+
+        /** @brief Dereference operator to access node data. */
+        reference operator*() const { return tree_->nodes_[index_].data_; }
+
+        /** @brief Member access to node data. */
+        pointer operator->() const { return &tree_->nodes_[index_].data_; }
+
+        /** @brief Pre-increment operator. */
+        Iterator& operator++() {
+            index_ = tree_->Next(index_);
+            return *this;
+        }
+
+        /** @brief Pre-decrement operator; end() steps to the last element. */
+        Iterator& operator--() {
+            index_ = tree_->Prev(index_);
+            return *this;
+        }
+
+        /** @brief Post-increment operator. */
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        /** @brief Post-decrement operator. */
+        Iterator operator--(int) {
+            Iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        /** @brief Equality comparison. */
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+        /** @brief Inequality comparison. */
+        bool operator!=(const Iterator& other) const {
+            return !(index_ == other.index_);
+        }
+    };
+
+    std::vector<CompactNode, node_allocator_type> nodes_;
+    Compare comp_;
+    uint32_t root_ = kNil;
+
+    /** @brief Returns the parent index of a node, without the colour bit. */
+    uint32_t Parent(uint32_t node) const {
+        return nodes_[node].parent_ & ~kRedBit;
+    }
+
+    /** @brief Sets the parent index of a node, keeping its colour. */
+    void SetParent(uint32_t node, uint32_t parent) {
+        nodes_[node].parent_ = (nodes_[node].parent_ & kRedBit) | parent;
+    }
+
+    /** @brief Checks whether a (possibly nil) node is red. */
+    bool IsRed(uint32_t node) const {
+        return node != kNil && (nodes_[node].parent_ & kRedBit) != 0;
+    }
+
+    /** @brief Sets the colour of a node. */
+    void SetRed(uint32_t node, bool red) {
+        nodes_[node].parent_ = red ? nodes_[node].parent_ | kRedBit
+                                   : nodes_[node].parent_ & ~kRedBit;
+    }
+
+    /** @brief Returns the link of a node's parent that points to the node. */
+    uint32_t& Link(uint32_t node) {
+        uint32_t parent = Parent(node);
+        if (parent == kNil) {
+            return root_;
+        }
+        return nodes_[parent].left_ == node ? nodes_[parent].left_
+                                            : nodes_[parent].right_;
+    }
+
+    /** @brief Returns the leftmost node of a non-empty subtree. */
+    uint32_t Leftmost(uint32_t node) const {
+        while (nodes_[node].left_ != kNil) {
+            node = nodes_[node].left_;
+        }
+        return node;
+    }
+
+    /** @brief Returns the rightmost node of a non-empty subtree. */
+    uint32_t Rightmost(uint32_t node) const {
+        while (nodes_[node].right_ != kNil) {
+            node = nodes_[node].right_;
+        }
+        return node;
+    }
+
+    /** @brief Returns the In-order successor, or kNil after the last node. */
+    uint32_t Next(uint32_t node) const {
+        if (nodes_[node].right_ != kNil) {
+            return Leftmost(nodes_[node].right_);
+        }
+        uint32_t parent = Parent(node);
+        while (parent != kNil && node == nodes_[parent].right_) {
+            node = parent;
+            parent = Parent(node);
+        }
+        return parent;
+    }
+
+    /** @brief Returns the In-order predecessor; kNil maps to the last node. */
+    uint32_t Prev(uint32_t node) const {
+        if (node == kNil) {
+            return root_ != kNil ? Rightmost(root_) : kNil;
+        }
+        if (nodes_[node].left_ != kNil) {
+            return Rightmost(nodes_[node].left_);
+        }
+        uint32_t parent = Parent(node);
+        while (parent != kNil && node == nodes_[parent].left_) {
+            node = parent;
+            parent = Parent(node);
+        }
+        return parent;
+    }
+
+    /** @brief Replaces the subtree at a node with the subtree at child. */
+    void Transplant(uint32_t node, uint32_t child) {
+        Link(node) = child;
+        if (child != kNil) {
+            SetParent(child, Parent(node));
+        }
+    }
+
+    /**
+     * @brief Rotates the subtree rooted at a node to the left.
+     * @param node The subtree root; its right child takes its place.
+     */
+    void RotateLeft(uint32_t node) {
+        uint32_t pivot = nodes_[node].right_;
+        nodes_[node].right_ = nodes_[pivot].left_;
+        if (nodes_[pivot].left_ != kNil) {
+            SetParent(nodes_[pivot].left_, node);
+        }
+        Transplant(node, pivot);
+        nodes_[pivot].left_ = node;
+        SetParent(node, pivot);
+    }
+
+    /**
+     * @brief Rotates the subtree rooted at a node to the right.
+     * @param node The subtree root; its left child takes its place.
+     */
+    void RotateRight(uint32_t node) {
+        uint32_t pivot = nodes_[node].left_;
+        nodes_[node].left_ = nodes_[pivot].right_;
+        if (nodes_[pivot].right_ != kNil) {
+            SetParent(nodes_[pivot].right_, node);
+        }
+        Transplant(node, pivot);
+        nodes_[pivot].right_ = node;
+        SetParent(node, pivot);
+    }
+
+    /**
+     * @brief Restores red-black properties after linking a new leaf.
+     * @param node The freshly linked node.
+     */
+    void InsertFixup(uint32_t node) {
+        SetRed(node, true);
+        // A red parent is never the root, so the grandparent exists.
+        while (IsRed(Parent(node))) {
+            uint32_t parent = Parent(node);
+            uint32_t grand = Parent(parent);
+            bool left = parent == nodes_[grand].left_;
+            uint32_t uncle = left ? nodes_[grand].right_ : nodes_[grand].left_;
+            if (IsRed(uncle)) {
+                SetRed(parent, false);
+                SetRed(uncle, false);
+                SetRed(grand, true);
+                node = grand;
+                continue;
+            }
+            if (left && node == nodes_[parent].right_) {
+                node = parent;
+                RotateLeft(node);
+                parent = Parent(node);
+            } else if (!left && node == nodes_[parent].left_) {
+                node = parent;
+                RotateRight(node);
+                parent = Parent(node);
+            }
+            SetRed(parent, false);
+            SetRed(grand, true);
+            if (left) {
+                RotateRight(grand);
+            } else {
+                RotateLeft(grand);
+            }
+        }
+        SetRed(root_, false);
+    }
+
+    /**
+     * @brief Restores red-black properties after unlinking a node.
+     * @param node The node that took the removed position (may be kNil).
+     * @param parent Parent of that position.
+     */
+    void EraseFixup(uint32_t node, uint32_t parent) {
+        while (node != root_ && !IsRed(node)) {
+            if (node == nodes_[parent].left_) {
+                uint32_t sibling = nodes_[parent].right_;
+                if (IsRed(sibling)) {
+                    SetRed(sibling, false);
+                    SetRed(parent, true);
+                    RotateLeft(parent);
+                    sibling = nodes_[parent].right_;
+                }
+                if (!IsRed(nodes_[sibling].left_) &&
+                    !IsRed(nodes_[sibling].right_)) {
+                    SetRed(sibling, true);
+                    node = parent;
+                    parent = Parent(parent);
+                } else {
+                    if (!IsRed(nodes_[sibling].right_)) {
+                        SetRed(nodes_[sibling].left_, false);
+                        SetRed(sibling, true);
+                        RotateRight(sibling);
+                        sibling = nodes_[parent].right_;
+                    }
+                    SetRed(sibling, IsRed(parent));
+                    SetRed(parent, false);
+                    SetRed(nodes_[sibling].right_, false);
+                    RotateLeft(parent);
+                    break;
+                }
+            } else {
+                uint32_t sibling = nodes_[parent].left_;
+                if (IsRed(sibling)) {
+                    SetRed(sibling, false);
+                    SetRed(parent, true);
+                    RotateRight(parent);
+                    sibling = nodes_[parent].left_;
+                }
+                if (!IsRed(nodes_[sibling].left_) &&
+                    !IsRed(nodes_[sibling].right_)) {
+                    SetRed(sibling, true);
+                    node = parent;
+                    parent = Parent(parent);
+                } else {
+                    if (!IsRed(nodes_[sibling].left_)) {
+                        SetRed(nodes_[sibling].right_, false);
+                        SetRed(sibling, true);
+                        RotateLeft(sibling);
+                        sibling = nodes_[parent].left_;
+                    }
+                    SetRed(sibling, IsRed(parent));
+                    SetRed(parent, false);
+                    SetRed(nodes_[sibling].left_, false);
+                    RotateRight(parent);
+                    break;
+                }
+            }
+        }
+        if (node != kNil) {
+            SetRed(node, false);
+        }
+    }
+
+    /**
+     * @brief Links the last slot of the vector at its upper-bound position.
+     * @return Index of the linked node.
+     */
+    uint32_t LinkBack() {
+        uint32_t node = static_cast<uint32_t>(nodes_.size() - 1);
+        uint32_t parent = kNil;
+        uint32_t* link = &root_;
+        try {
+            while (*link != kNil) {
+                parent = *link;
+                link = comp_(nodes_[node].data_, nodes_[parent].data_)
+                           ? &nodes_[parent].left_
+                           : &nodes_[parent].right_;
+            }
+        } catch (...) {
+            nodes_.pop_back();
+            throw;
+        }
+        *link = node;
+        nodes_[node].parent_ = parent;
+        InsertFixup(node);
+        return node;
+    }
+
+    /**
+     * @brief Detaches a node from the tree and rebalances.
+     * @param node Index of the node to unlink; its slot stays allocated.
+     */
+    void UnlinkNode(uint32_t node) {
+        uint32_t child;
+        uint32_t parent;
+        bool removed_red = IsRed(node);
+        if (nodes_[node].left_ == kNil || nodes_[node].right_ == kNil) {
+            child = nodes_[node].left_ != kNil ? nodes_[node].left_
+                                               : nodes_[node].right_;
+            parent = Parent(node);
+            Transplant(node, child);
+        } else {
+            uint32_t next = Leftmost(nodes_[node].right_);
+            removed_red = IsRed(next);
+            child = nodes_[next].right_;
+            if (Parent(next) == node) {
+                parent = next;
+            } else {
+                parent = Parent(next);
+                Transplant(next, child);
+                nodes_[next].right_ = nodes_[node].right_;
+                SetParent(nodes_[next].right_, next);
+            }
+            Transplant(node, next);
+            nodes_[next].left_ = nodes_[node].left_;
+            SetParent(nodes_[next].left_, next);
+            SetRed(next, IsRed(node));
+        }
+        if (!removed_red) {
+            EraseFixup(child, parent);
+        }
+    }
+
+    /**
+     * @brief Frees an unlinked slot by moving the last node into it.
+     * @param slot Index of the unlinked node.
+     */
+    void RemoveSlot(uint32_t slot) {
+        uint32_t last = static_cast<uint32_t>(nodes_.size() - 1);
+        if (slot != last) {
+            Link(last) = slot;
+            nodes_[slot] = std::move(nodes_[last]);
+            if (nodes_[slot].left_ != kNil) {
+                SetParent(nodes_[slot].left_, slot);
+            }
+            if (nodes_[slot].right_ != kNil) {
+                SetParent(nodes_[slot].right_, slot);
+            }
+        }
+        nodes_.pop_back();
+    }
+
+    /**
+     * @brief Unlinks and frees a node.
+     * @return Index of its former In-order successor after the slot move.
+     */
+    uint32_t EraseIndex(uint32_t node) {
+        uint32_t next = Next(node);
+        UnlinkNode(node);
+        RemoveSlot(node);
+        return next == nodes_.size() ? node : next;
+    }
+
+    /** @brief Descends to the first node not less than the value. */
+    template <class K>
+    uint32_t LowerBoundIndex(const K& value) const {
+        uint32_t result = kNil;
+        uint32_t current = root_;
+        while (current != kNil) {
+            if (comp_(nodes_[current].data_, value)) {
+                current = nodes_[current].right_;
+            } else {
+                result = current;
+                current = nodes_[current].left_;
+            }
+        }
+        return result;
+    }
+
+    /** @brief Descends to the first node greater than the value. */
+    template <class K>
+    uint32_t UpperBoundIndex(const K& value) const {
+        uint32_t result = kNil;
+        uint32_t current = root_;
+        while (current != kNil) {
+            if (comp_(value, nodes_[current].data_)) {
+                result = current;
+                current = nodes_[current].left_;
+            } else {
+                current = nodes_[current].right_;
+            }
+        }
+        return result;
+    }
+
+    /** @brief Hints the cache that a (possibly nil) node is read next. */
+    void Prefetch(uint32_t node) const {
+#if defined(__GNUC__) || defined(__clang__)
+        if (node != kNil) {
+            __builtin_prefetch(&nodes_[node]);
+        }
+#else
+        (void)node;
+#endif
+    }
+
+    /** @brief Orders two keys through KeyLess(). */
+    bool Less(const T& value, const T& key) const {
+        return KeyLess<T>(comp_, value, key);
+    }
+
+    /**
+     * @brief Runs lower-bound descents for a batch of keys side by side.
+     *
+     * Up to kBatchLanes descents advance one level per round so that their
+     * cache misses overlap. For arithmetic keys under std::less each step is
+     * a plain comparison and conditional moves.
+     * @param keys The keys to look up.
+     * @param emit Called as emit(i, node) with the lower bound of keys[i].
+     */
+    template <class Emit>
+    void LowerBoundBatch(std::span<const T> keys, Emit emit) const {
+        for (size_t base = 0; base < keys.size(); base += kBatchLanes) {
+            size_t lanes = std::min(kBatchLanes, keys.size() - base);
+            const T* key = keys.data() + base;
+            uint32_t current[kBatchLanes];
+            uint32_t result[kBatchLanes];
+            std::fill(current, current + lanes, root_);
+            std::fill(result, result + lanes, kNil);
+            for (bool active = root_ != kNil; active;) {
+                active = false;
+                for (size_t lane = 0; lane < lanes; ++lane) {
+                    uint32_t node = current[lane];
+                    if (node == kNil) {
+                        continue;
+                    }
+                    bool right = Less(nodes_[node].data_, key[lane]);
+                    result[lane] = right ? result[lane] : node;
+                    current[lane] =
+                        right ? nodes_[node].right_ : nodes_[node].left_;
+                    Prefetch(current[lane]);
+                    active |= current[lane] != kNil;
+                }
+            }
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                emit(base + lane, result[lane]);
+            }
+        }
+    }
+
+    /** @brief Returns the first node equal to the value, or kNil. */
+    template <class K>
+    uint32_t FindIndex(const K& value) const {
+        uint32_t node = LowerBoundIndex(value);
+        if (node != kNil && comp_(value, nodes_[node].data_)) {
+            return kNil;
+        }
+        return node;
+    }
+
+   public:
+    using value_type = T;
+    using key_type = T;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using allocator_type = Alloc;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    /** @brief Default constructor. Creates an empty tree. */
+    CompactBST() = default;
+
+    /** @brief Creates an empty tree with a comparator and allocator. */
+    explicit CompactBST(const Compare& comp, const Alloc& alloc = Alloc())
+        : nodes_(node_allocator_type(alloc)), comp_(comp) {}
+
+    /** @brief Constructs a tree from a range of elements. */
+    template <class InputIt>
+    CompactBST(InputIt first, InputIt last) {
+        insert(first, last);
+    }
+
+    /** @brief Constructs a tree from an initializer list. */
+    CompactBST(std::initializer_list<T> il) { insert(il.begin(), il.end()); }
+
+    /** @brief Returns an iterator to the smallest element. */
+    Iterator begin() const {
+        return Iterator(this, root_ != kNil ? Leftmost(root_) : kNil);
+    }
+
+    /** @brief Returns the past-the-end iterator. */
+    Iterator end() const { return Iterator(this, kNil); }
+
+    /** @brief Returns a constant iterator to the smallest element. */
+    Iterator cbegin() const { return begin(); }
+
+    /** @brief Returns the constant past-the-end iterator. */
+    Iterator cend() const { return end(); }
+
+    /** @brief Checks if the tree is empty. */
+    bool empty() const { return nodes_.empty(); }
+
+    /** @brief Returns the number of elements. */
+    size_t size() const { return nodes_.size(); }
+
+    /** @brief Returns the maximum number of elements (limited by the index width). */
+    size_t max_size() const { return kNil; }
+
+    /** @brief Returns the number of node slots allocated. */
+    size_t capacity() const { return nodes_.capacity(); }
+
+    /** @brief Reserves node storage for at least n elements. */
+    void reserve(size_t n) { nodes_.reserve(n); }
+
+    /** @brief Releases unused node storage. */
+    void shrink_to_fit() { nodes_.shrink_to_fit(); }
+
+    /** @brief Removes all elements. */
+    void clear() {
+        nodes_.clear();
+        root_ = kNil;
+    }
+
+    /** @brief Swaps contents with another tree. */
+    void swap(CompactBST& other) noexcept {
+        using std::swap;
+        swap(nodes_, other.nodes_);
+        swap(comp_, other.comp_);
+        swap(root_, other.root_);
+    }
+
+    /**
+     * @brief Constructs an element in place at its upper-bound position.
+     * @return Iterator to the new element.
+     */
+    template <class... Args>
+    Iterator emplace(Args&&... args) {
+        if (nodes_.size() >= kNil) {
+            throw std::length_error("CompactBST: index space exhausted");
+        }
+        nodes_.emplace_back(std::in_place, std::forward<Args>(args)...);
+        return Iterator(this, LinkBack());
+    }
+
+    /** @brief Inserts a copy of the value. */
+    Iterator insert(const T& value) { return emplace(value); }
+
+    /** @brief Inserts the value by moving it. */
+    Iterator insert(T&& value) { return emplace(std::move(value)); }
+
+    /** @brief Inserts elements from a range. */
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            emplace(*first);
+        }
+    }
+
+    /** @brief Inserts elements from an initializer list. */
+    void insert(std::initializer_list<T> il) { insert(il.begin(), il.end()); }
+
+    /**
+     * @brief Erases the element at an iterator.
+     * @return Iterator to the next element.
+     */
+    Iterator erase(Iterator it) {
+        if (it.index_ == kNil) {
+            return it;
+        }
+        return Iterator(this, EraseIndex(it.index_));
+    }
+
+    /**
+     * @brief Erases every element equal to the value.
+     * @return The number of elements removed.
+     */
+    size_t erase(const T& value) {
+        size_t count = 0;
+        uint32_t node = LowerBoundIndex(value);
+        while (node != kNil && !comp_(value, nodes_[node].data_)) {
+            node = EraseIndex(node);
+            ++count;
+        }
+        return count;
+    }
+
+    /** @brief Returns an iterator to the first element equal to the value. */
+    Iterator find(const T& value) const {
+        return Iterator(this, FindIndex(value));
+    }
+
+    /** @brief Heterogeneous find for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator find(const K& key) const {
+        return Iterator(this, FindIndex(key));
+    }
+
+    /** @brief Checks whether an element equal to the value exists. */
+    bool contains(const T& value) const { return FindIndex(value) != kNil; }
+
+    /** @brief Heterogeneous contains for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    bool contains(const K& key) const {
+        return FindIndex(key) != kNil;
+    }
+
+    /**
+     * @brief Finds a batch of keys at once, interleaving their descents.
+     * @param keys The keys to look up.
+     * @param out Receives find(keys[i]) at index i; must hold keys.size()
+     * iterators.
+     */
+    void find_batch(std::span<const T> keys, std::span<Iterator> out) const {
+        LowerBoundBatch(keys, [&](size_t i, uint32_t node) {
+            if (node != kNil && comp_(keys[i], nodes_[node].data_)) {
+                node = kNil;
+            }
+            out[i] = Iterator(this, node);
+        });
+    }
+
+    /**
+     * @brief Checks a batch of keys at once, interleaving their descents.
+     * @param out Receives contains(keys[i]) at index i; must hold
+     * keys.size() flags.
+     */
+    void contains_batch(std::span<const T> keys, std::span<bool> out) const {
+        LowerBoundBatch(keys, [&](size_t i, uint32_t node) {
+            out[i] = node != kNil && !comp_(keys[i], nodes_[node].data_);
+        });
+    }
+
+    /** @brief Returns the number of elements equal to the value. */
+    size_t count(const T& value) const {
+        auto range = equal_range(value);
+        return static_cast<size_t>(std::distance(range.first, range.second));
+    }
+
+    /** @brief Returns an iterator to the first element not less than the value. */
+    Iterator lower_bound(const T& value) const {
+        return Iterator(this, LowerBoundIndex(value));
+    }
+
+    /** @brief Heterogeneous lower_bound for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator lower_bound(const K& key) const {
+        return Iterator(this, LowerBoundIndex(key));
+    }
+
+    /** @brief Returns an iterator to the first element greater than the value. */
+    Iterator upper_bound(const T& value) const {
+        return Iterator(this, UpperBoundIndex(value));
+    }
+
+    /** @brief Heterogeneous upper_bound for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator upper_bound(const K& key) const {
+        return Iterator(this, UpperBoundIndex(key));
+    }
+
+    /** @brief Returns the range of elements equal to the value. */
+    std::pair<Iterator, Iterator> equal_range(const T& value) const {
+        return {lower_bound(value), upper_bound(value)};
+    }
+
+    /** @brief Returns the comparison object. */
+    Compare key_comp() const { return comp_; }
+
+    /** @brief Returns the comparison object. */
+    Compare value_comp() const { return comp_; }
+
+    /** @brief Returns the allocator. */
+    Alloc get_allocator() const { return Alloc(nodes_.get_allocator()); }
+
+    /** @brief Returns the number of bytes taken by one node. */
+    static constexpr size_t node_size() { return sizeof(CompactNode); }
+
+    /** @brief Checks whether two trees hold the same sequence of elements. */
+    bool operator==(const CompactBST& other) const {
+        return size() == other.size() &&
+               std::equal(begin(), end(), other.begin());
+    }
+
+    /** @brief Checks whether two trees differ. */
+    bool operator!=(const CompactBST& other) const { return !(*this == other); }
+};
+
+/** @brief Swaps the contents of two compact trees. */
+template <class T, class Compare, class Alloc>
+void swap(CompactBST<T, Compare, Alloc>& lhs,
+          CompactBST<T, Compare, Alloc>& rhs) noexcept {
+    lhs.swap(rhs);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+/**
+ * @brief Whether keys compare with a plain `<`: arithmetic keys under
+ * std::less. The trees then select children with conditional moves
+ * instead of branching on the comparator.
+ */
+template <class T, class Compare>
+inline constexpr bool kArithmeticLess =
+    std::is_arithmetic_v<T> && (std::is_same_v<Compare, std::less<T>> ||
+                                std::is_same_v<Compare, std::less<>>);
+
+/** @brief Number of descents interleaved by the batched lookups. */
+inline constexpr size_t kBatchLanes = 16;
+
+/**
+ * @brief Orders two keys: with a plain `<` when both are T and
+ * kArithmeticLess holds, otherwise through the comparator.
+ */
+template <class T, class Compare, class A, class B>
+bool KeyLess(const Compare& comp, const A& value, const B& key) {
+    if constexpr (kArithmeticLess<T, Compare> && std::is_same_v<A, T> &&
+                  std::is_same_v<B, T>) {
+        return value < key;
+    } else {
+        return comp(value, key);
+    }
+}
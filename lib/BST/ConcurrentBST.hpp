@@ -0,0 +1,222 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "BST.hpp"
+
+/**
+ * @brief Thread-safe BST wrapper with wait-free readers (Left-Right scheme).
+ *
+ * Two copies of the tree are kept. Readers never lock: they announce
+ * themselves on a striped counter and read whichever copy is published.
+ * A single writer at a time (serialised by a mutex) applies each update
+ * to the hidden copy, publishes it, waits until readers have drained from
+ * the old copy and then replays the update there. Reads therefore scale
+ * with the number of cores and never observe a half-applied update; the
+ * cost is twice the memory, every update running twice, and a writer
+ * waiting for the read sections in flight, so read sections should be short.
+ * @tparam T Type of the elements.
+ * @tparam Compare Comparison functor for ordering.
+ * @tparam Alloc Allocator for memory management.
+ * @tparam Balance Balancing policy of the underlying trees.
+ * @tparam Augment Node augmentation of the underlying trees.
+ */
+template <class T, class Compare = std::less<T>,
+          class Alloc = std::allocator<T>, class Balance = RedBlack,
+          class Augment = NoAugment>
+class ConcurrentBST {
+   public:
+    using tree_type = BST<T, Compare, Alloc, Balance, Augment>;
+
+   private:
+    /** @brief Number of reader counters; readers spread over them by thread. */
+    static constexpr size_t kStripes = 16;
+    /** @brief Spacing that keeps each counter on its own cache line. */
+    static constexpr size_t kLine = 64;
+
+    /** @brief Counts the readers currently inside one version of the tree. */
+    class ReaderIndicator {
+       private:
+        struct alignas(kLine) Stripe {
+            std::atomic<size_t> count_{0};
+        };
+
+        Stripe stripes_[kStripes];
+
+        /** @brief Returns the stripe used by the calling thread. */
+        static size_t StripeIndex() {
+            static std::atomic<size_t> next{0};
+            thread_local size_t index = next.fetch_add(1) % kStripes;
+            return index;
+        }
+
+       public:
+        /** @brief Registers the calling thread as a reader. */
+        size_t arrive() {
+            size_t stripe = StripeIndex();
+            stripes_[stripe].count_.fetch_add(1);
+            return stripe;
+        }
+
+        /** @brief Unregisters a reader registered on a stripe. */
+        void depart(size_t stripe) { stripes_[stripe].count_.fetch_sub(1); }
+
+        /** @brief Checks whether no reader is registered. */
+        bool empty() const {
+            for (const Stripe& stripe : stripes_) {
+                if (stripe.count_.load() != 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    tree_type trees_[2];
+    std::atomic<int> published_{0};
+    std::atomic<int> version_{0};
+    mutable ReaderIndicator readers_[2];
+    std::mutex writer_;
+
+    /** @brief Spins until a reader indicator drains. */
+    static void WaitEmpty(const ReaderIndicator& readers) {
+        while (!readers.empty()) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Makes sure no reader still sees the copy unpublished last.
+     *
+     * Readers arrive on the indicator of the current version before reading
+     * the published index; flipping the version between two drains
+     * guarantees every reader that could have read the old index is gone.
+     */
+    void DrainReaders() {
+        int previous = version_.load();
+        int next = 1 - previous;
+        WaitEmpty(readers_[next]);
+        version_.store(next);
+        WaitEmpty(readers_[previous]);
+    }
+
+    /** @brief Publishes a copy and waits for readers of the other to leave. */
+    void Publish(int copy) {
+        published_.store(copy);
+        DrainReaders();
+    }
+
+   public:
+    /** @brief Default constructor. Creates an empty tree. */
+    ConcurrentBST() = default;
+
+    /** @brief Constructs from an initializer list. */
+    ConcurrentBST(initializer_list<T> il)
+        : trees_{tree_type(il), tree_type(il)} {}
+
+    ConcurrentBST(const ConcurrentBST&) = delete;
+    ConcurrentBST& operator=(const ConcurrentBST&) = delete;
+
+    /**
+     * @brief Runs a read-only function on a consistent version of the tree.
+     *
+     * Never blocks. Iterators and references obtained inside fn must not
+     * escape it: the version may be modified once fn returns.
+     * @param fn Callable taking const tree_type&.
+     * @return Whatever fn returns.
+     */
+    template <class Fn>
+    decltype(auto) read(Fn&& fn) const {
+        int version = version_.load();
+        size_t stripe = readers_[version].arrive();
+        struct Departure {
+            ReaderIndicator& readers_;
+            size_t stripe_;
+            ~Departure() { readers_.depart(stripe_); }
+        } departure{readers_[version], stripe};
+        return std::invoke(std::forward<Fn>(fn),
+                           std::as_const(trees_[published_.load()]));
+    }
+
+    /**
+     * @brief Applies an update to the tree, visible to readers atomically.
+     *
+     * fn runs twice, once per copy, and must make the same change both
+     * times. If it throws, the copies are resynchronised from the published
+     * one and the exception is rethrown.
+     * @param fn Callable taking tree_type&.
+     * @return The result of the first application of fn.
+     */
+    template <class Fn>
+    decltype(auto) write(Fn&& fn) {
+        std::lock_guard<std::mutex> lock(writer_);
+        int shown = published_.load();
+        int hidden = 1 - shown;
+        try {
+            using result_type = std::invoke_result_t<Fn&, tree_type&>;
+            if constexpr (std::is_void_v<result_type>) {
+                std::invoke(fn, trees_[hidden]);
+                Publish(hidden);
+                std::invoke(fn, trees_[shown]);
+            } else {
+                auto result = std::invoke(fn, trees_[hidden]);
+                Publish(hidden);
+                std::invoke(fn, trees_[shown]);
+                return result;
+            }
+        } catch (...) {
+            // Readers are never on the unpublished copy, so it can be reset.
+            int current = published_.load();
+            trees_[1 - current] = trees_[current];
+            throw;
+        }
+    }
+
+    /** @brief Inserts a value. */
+    void insert(const T& value) {
+        write([&](tree_type& tree) { tree.insert(value); });
+    }
+
+    /**
+     * @brief Erases every element equal to the value.
+     * @return The number of elements removed.
+     */
+    size_t erase(const T& value) {
+        return write([&](tree_type& tree) { return tree.erase(value); });
+    }
+
+    /** @brief Removes all elements. */
+    void clear() {
+        write([](tree_type& tree) { tree.clear(); });
+    }
+
+    /** @brief Checks if the value exists in the tree. */
+    bool contains(const T& value) const {
+        return read(
+            [&](const tree_type& tree) { return tree.contains(value); });
+    }
+
+    /** @brief Counts the elements equal to the value. */
+    size_t count(const T& value) const {
+        return read([&](const tree_type& tree) { return tree.count(value); });
+    }
+
+    /** @brief Returns the number of elements. */
+    size_t size() const {
+        return read([](const tree_type& tree) { return tree.size(); });
+    }
+
+    /** @brief Checks if the tree is empty. */
+    bool empty() const { return size() == 0; }
+
+    /** @brief Returns a deep copy of the current version. */
+    tree_type snapshot() const {
+        return read([](const tree_type& tree) { return tree; });
+    }
+};
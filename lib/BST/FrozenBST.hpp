@@ -0,0 +1,542 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BST_HAS_MMAP 1
+#endif
+
+#include "Compare.hpp"
+#include "Snapshot.hpp"
+
+/**
+ * @brief Immutable sorted snapshot stored in Eytzinger (BFS) order.
+ *
+ * Element k (1-based) has children 2k and 2k + 1, so the top levels of the
+ * implicit tree share a few cache lines and every descent walks one
+ * contiguous array. Searches are branchless: each step turns the comparison
+ * into the next index, and the subtree four levels down is prefetched while
+ * the current comparison resolves. Built in O(n) from sorted input, usually
+ * through BST::freeze(), or opened straight from a file saved earlier.
+ * The element array is immutable and shared between copies; it is either
+ * owned or a read-only memory mapping.
+ * @tparam T Type of the elements.
+ * @tparam Compare Comparison function object type.
+ */
+template <class T, class Compare = std::less<T>>
+class FrozenBST {
+   private:
+    /**
+     * @brief Bidirectional In-order iterator walking the implicit tree.
+     *
+     * It points into the shared element array, not at the snapshot object,
+     * so it stays valid while any snapshot sharing that array is alive,
+     * including after the one it came from is moved or destroyed.
+     */
+    class Iterator {
+        friend class FrozenBST;
+
+       private:
+        const T* data_;
+        size_t size_;
+        size_t index_;
+
+        Iterator(const FrozenBST* tree, size_t index)
+            : data_(tree->data_), size_(tree->size_), index_(index) {}
+
+       public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator() : data_(nullptr), size_(0), index_(0) {}
+
+        /** @brief Dereference operator to access the element. */
+        reference operator*() const { return data_[index_ - 1]; }
+
+        /** @brief Member access to the element. */
+        pointer operator->() const { return data_ + index_ - 1; }
+
+        /** @brief Pre-increment operator. */
+        Iterator& operator++() {
+            index_ = FrozenBST::Next(index_, size_);
+            return *this;
+        }
+
+        /** @brief Pre-decrement operator; end() steps to the last element. */
+        Iterator& operator--() {
+            index_ = FrozenBST::Prev(index_, size_);
+            return *this;
+        }
+
+        /** @brief Post-increment operator. */
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        /** @brief Post-decrement operator. */
+        Iterator operator--(int) {
+            Iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        /** @brief Equality comparison. */
+        bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+        /** @brief Inequality comparison. */
+        bool operator!=(const Iterator& other) const {
+            return !(index_ == other.index_);
+        }
+    };
+
+    /** @brief Elements read at a time by load(). */
+    static constexpr size_t kSnapshotChunk = 4096;
+
+    std::shared_ptr<const T> storage_;
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+    Compare comp_;
+
+    /** @brief Takes ownership of an element array in Eytzinger order. */
+    void Adopt(std::shared_ptr<std::vector<T>> layout) {
+        data_ = layout->data();
+        size_ = layout->size();
+        storage_ = std::shared_ptr<const T>(std::move(layout), data_);
+    }
+
+    /**
+     * @brief Checks in O(n) that an In-order walk of the layout never goes
+     * backwards.
+     * @throws std::runtime_error if the elements are not in Eytzinger order.
+     */
+    void ValidateOrder() const {
+        if (size_ == 0) {
+            return;
+        }
+        size_t prev = Leftmost(1, size_);
+        for (size_t index = Next(prev, size_); index != 0;
+             index = Next(index, size_)) {
+            if (comp_(At(index), At(prev))) {
+                throw std::runtime_error(
+                    "snapshot: elements are not in Eytzinger order");
+            }
+            prev = index;
+        }
+    }
+
+    /** @brief Returns the element at a 1-based Eytzinger index. */
+    const T& At(size_t index) const { return data_[index - 1]; }
+
+    /**
+     * @brief Returns the leftmost index of the subtree rooted at an index.
+     *
+     * The navigation helpers take the element count so that iterators can
+     * walk the array without their snapshot.
+     */
+    static size_t Leftmost(size_t index, size_t size) {
+        while (2 * index <= size) {
+            index = 2 * index;
+        }
+        return index;
+    }
+
+    /** @brief Returns the rightmost index of the subtree rooted at an index. */
+    static size_t Rightmost(size_t index, size_t size) {
+        while (2 * index + 1 <= size) {
+            index = 2 * index + 1;
+        }
+        return index;
+    }
+
+    /** @brief Returns the In-order successor, or 0 after the last element. */
+    static size_t Next(size_t index, size_t size) {
+        if (2 * index + 1 <= size) {
+            return Leftmost(2 * index + 1, size);
+        }
+        // Climb past the ancestors whose right subtree we are finishing.
+        return index >> (std::countr_one(index) + 1);
+    }
+
+    /** @brief Returns the In-order predecessor; 0 maps to the last element. */
+    static size_t Prev(size_t index, size_t size) {
+        if (index == 0) {
+            return size == 0 ? 0 : Rightmost(1, size);
+        }
+        if (2 * index <= size) {
+            return Rightmost(2 * index, size);
+        }
+        return index >> (std::countr_zero(index) + 1);
+    }
+
+    /** @brief Hints the cache about the subtree four levels below an index. */
+    void Prefetch(size_t index) const {
+#if defined(__GNUC__) || defined(__clang__)
+        size_t ahead = 16 * index;
+        if (ahead <= size_) {
+            __builtin_prefetch(&At(ahead));
+        }
+#else
+        (void)index;
+#endif
+    }
+
+    /**
+     * @brief Branchless descent shared by the bounds.
+     * @param go_right Predicate telling whether the answer lies right of an
+     * element.
+     * @return Index of the first element for which go_right is false, or 0.
+     */
+    template <class GoRight>
+    size_t Descend(GoRight go_right) const {
+        size_t index = 1;
+        while (index <= size_) {
+            Prefetch(index);
+            index = 2 * index + static_cast<size_t>(go_right(At(index)));
+        }
+        // The answer is the last node where the descent turned left.
+        return index >> (std::countr_one(index) + 1);
+    }
+
+    /** @brief Index of the first element not less than the key. */
+    template <class K>
+    size_t LowerBoundIndex(const K& key) const {
+        return Descend([&](const T& value) { return comp_(value, key); });
+    }
+
+    /** @brief Index of the first element greater than the key. */
+    template <class K>
+    size_t UpperBoundIndex(const K& key) const {
+        return Descend([&](const T& value) { return !comp_(key, value); });
+    }
+
+    /** @brief Orders two keys through KeyLess(). */
+    bool Less(const T& value, const T& key) const {
+        return KeyLess<T>(comp_, value, key);
+    }
+
+    /**
+     * @brief Runs lower-bound descents for a batch of keys in lockstep.
+     *
+     * Every descent takes the same number of steps, so the lanes advance
+     * level by level without per-lane control flow: all levels above the
+     * partial bottom one are full and need no bounds check. For arithmetic
+     * keys under std::less the inner loop is a gather, a compare and a
+     * shift-add that compilers can vectorize.
+     * @param keys The keys to look up.
+     * @param emit Called as emit(i, index) with the lower bound of keys[i].
+     */
+    template <class Emit>
+    void LowerBoundBatch(std::span<const T> keys, Emit emit) const {
+        size_t full_levels = std::bit_width(size_ + 1) - 1;
+        for (size_t base = 0; base < keys.size(); base += kBatchLanes) {
+            size_t lanes = std::min(kBatchLanes, keys.size() - base);
+            const T* key = keys.data() + base;
+            size_t index[kBatchLanes];
+            std::fill(index, index + lanes, size_t{1});
+            for (size_t level = 0; level < full_levels; ++level) {
+                for (size_t lane = 0; lane < lanes; ++lane) {
+                    Prefetch(index[lane]);
+                    index[lane] = 2 * index[lane] +
+                                  Less(At(index[lane]), key[lane]);
+                }
+            }
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                if (index[lane] <= size_) {
+                    index[lane] = 2 * index[lane] +
+                                  Less(At(index[lane]), key[lane]);
+                }
+                size_t found = index[lane] >> (std::countr_one(index[lane]) + 1);
+                emit(base + lane, found);
+            }
+        }
+    }
+
+    /** @brief Index of the first element equal to the key, or 0. */
+    template <class K>
+    size_t FindIndex(const K& key) const {
+        size_t index = LowerBoundIndex(key);
+        return index != 0 && !comp_(key, At(index)) ? index : 0;
+    }
+
+   public:
+    using value_type = T;
+    using key_type = T;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    /** @brief Default constructor. Creates an empty snapshot. */
+    FrozenBST() = default;
+
+    /**
+     * @brief Lays out a sorted range in Eytzinger order.
+     * @param first Beginning of a range sorted by comp.
+     * @param last End of the range.
+     * @param comp Comparison object used by the searches.
+     */
+    template <class InputIt>
+    FrozenBST(InputIt first, InputIt last, const Compare& comp = Compare())
+        : comp_(comp) {
+        std::vector<T> sorted;
+        for (; first != last; ++first) {
+            sorted.push_back(*first);
+        }
+        size_ = sorted.size();
+        if (size_ == 0) {
+            return;
+        }
+        // Visiting the implicit tree in order gives each slot its sorted rank.
+        std::vector<size_t> rank(size_);
+        size_t index = Leftmost(1, size_);
+        for (size_t i = 0; i < size_; ++i) {
+            rank[index - 1] = i;
+            index = Next(index, size_);
+        }
+        auto layout = std::make_shared<std::vector<T>>();
+        layout->reserve(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            layout->push_back(std::move(sorted[rank[i]]));
+        }
+        Adopt(std::move(layout));
+    }
+
+    /**
+     * @brief Writes the snapshot in the binary Eytzinger layout.
+     * @throws std::runtime_error if the stream fails.
+     */
+    void save(std::ostream& out) const {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "save() requires a trivially copyable element type");
+        auto header = SnapshotHeader::Make<T>(SnapshotLayout::Eytzinger, size_);
+        WriteSnapshotBytes(out, &header, sizeof(header));
+        WriteSnapshotBytes(out, data_, size_ * sizeof(T));
+    }
+
+    /** @brief Writes the snapshot to a file. */
+    void save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        save(out);
+    }
+
+    /**
+     * @brief Reads a snapshot written by save() into memory.
+     *
+     * Elements are read kSnapshotChunk at a time, so a forged count fails
+     * as a truncated input instead of allocating it up front.
+     * @throws std::runtime_error on a malformed, misordered or truncated input.
+     */
+    static FrozenBST load(std::istream& in) {
+        uint64_t count = ReadSnapshotHeader<T>(in, SnapshotLayout::Eytzinger);
+        auto layout = std::make_shared<std::vector<T>>();
+        for (uint64_t left = count; left != 0;) {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(left, kSnapshotChunk));
+            size_t offset = layout->size();
+            layout->resize(offset + chunk);
+            ReadSnapshotBytes(in, layout->data() + offset, chunk * sizeof(T));
+            left -= chunk;
+        }
+        FrozenBST frozen;
+        frozen.Adopt(std::move(layout));
+        frozen.ValidateOrder();
+        return frozen;
+    }
+
+    /** @brief Reads a snapshot file into memory. */
+    static FrozenBST load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("snapshot: cannot open " + path);
+        }
+        return load(in);
+    }
+
+    /**
+     * @brief Serves a snapshot file directly from a read-only memory mapping.
+     *
+     * No element is copied or parsed, so opening is O(1) and pages are
+     * faulted in by the first lookups touching them. The mapping lives as
+     * long as any copy of the returned snapshot. Falls back to load() where
+     * mmap is unavailable. The element order is verified in O(n) before
+     * the mapping is handed out.
+     * @throws std::runtime_error on a malformed, misordered or truncated file.
+     */
+    static FrozenBST mmap_open(const std::string& path) {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "mmap_open() requires a trivially copyable element type");
+#ifdef BST_HAS_MMAP
+        static_assert(alignof(T) <= sizeof(SnapshotHeader),
+                      "mapped elements must fit the header alignment");
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("snapshot: cannot open " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 ||
+            static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            throw std::runtime_error("snapshot: truncated input");
+        }
+        size_t length = static_cast<size_t>(info.st_size);
+        void* base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("snapshot: mmap failed for " + path);
+        }
+        std::shared_ptr<const void> mapping(
+            base, [length](const void* p) { ::munmap(const_cast<void*>(p), length); });
+        SnapshotHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        header.Validate<T>(SnapshotLayout::Eytzinger);
+        if ((length - sizeof(header)) / sizeof(T) < header.count_) {
+            throw std::runtime_error("snapshot: truncated input");
+        }
+        FrozenBST frozen;
+        frozen.data_ = reinterpret_cast<const T*>(
+            static_cast<const char*>(base) + sizeof(header));
+        frozen.size_ = header.count_;
+        frozen.storage_ = std::shared_ptr<const T>(mapping, frozen.data_);
+        frozen.ValidateOrder();
+        return frozen;
+#else
+        return load(path);
+#endif
+    }
+
+    /** @brief Returns an iterator to the smallest element. */
+    Iterator begin() const {
+        return Iterator(this, size_ == 0 ? 0 : Leftmost(1, size_));
+    }
+
+    /** @brief Returns the past-the-end iterator. */
+    Iterator end() const { return Iterator(this, 0); }
+
+    /** @brief Returns a constant iterator to the smallest element. */
+    Iterator cbegin() const { return begin(); }
+
+    /** @brief Returns the constant past-the-end iterator. */
+    Iterator cend() const { return end(); }
+
+    /** @brief Checks if the snapshot is empty. */
+    bool empty() const { return size_ == 0; }
+
+    /** @brief Returns the number of elements. */
+    size_t size() const { return size_; }
+
+    /** @brief Returns an iterator to the first element equal to the value. */
+    Iterator find(const T& value) const {
+        return Iterator(this, FindIndex(value));
+    }
+
+    /** @brief Heterogeneous find for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator find(const K& key) const {
+        return Iterator(this, FindIndex(key));
+    }
+
+    /** @brief Checks whether an element equal to the value exists. */
+    bool contains(const T& value) const { return FindIndex(value) != 0; }
+
+    /** @brief Heterogeneous contains for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    bool contains(const K& key) const {
+        return FindIndex(key) != 0;
+    }
+
+    /**
+     * @brief Finds a batch of keys at once, descending them in lockstep.
+     * @param keys The keys to look up.
+     * @param out Receives find(keys[i]) at index i; must hold keys.size()
+     * iterators.
+     */
+    void find_batch(std::span<const T> keys, std::span<Iterator> out) const {
+        LowerBoundBatch(keys, [&](size_t i, size_t index) {
+            if (index != 0 && comp_(keys[i], At(index))) {
+                index = 0;
+            }
+            out[i] = Iterator(this, index);
+        });
+    }
+
+    /**
+     * @brief Checks a batch of keys at once, descending them in lockstep.
+     * @param out Receives contains(keys[i]) at index i; must hold
+     * keys.size() flags.
+     */
+    void contains_batch(std::span<const T> keys, std::span<bool> out) const {
+        LowerBoundBatch(keys, [&](size_t i, size_t index) {
+            out[i] = index != 0 && !comp_(keys[i], At(index));
+        });
+    }
+
+    /** @brief Returns the number of elements equal to the value. */
+    size_t count(const T& value) const {
+        auto range = equal_range(value);
+        return static_cast<size_t>(std::distance(range.first, range.second));
+    }
+
+    /** @brief Returns an iterator to the first element not less than the value. */
+    Iterator lower_bound(const T& value) const {
+        return Iterator(this, LowerBoundIndex(value));
+    }
+
+    /** @brief Heterogeneous lower_bound for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator lower_bound(const K& key) const {
+        return Iterator(this, LowerBoundIndex(key));
+    }
+
+    /** @brief Returns an iterator to the first element greater than the value. */
+    Iterator upper_bound(const T& value) const {
+        return Iterator(this, UpperBoundIndex(value));
+    }
+
+    /** @brief Heterogeneous upper_bound for transparent comparators. */
+    template <class K, class C = Compare, class = typename C::is_transparent>
+    Iterator upper_bound(const K& key) const {
+        return Iterator(this, UpperBoundIndex(key));
+    }
+
+    /** @brief Returns the range of elements equal to the value. */
+    std::pair<Iterator, Iterator> equal_range(const T& value) const {
+        return {lower_bound(value), upper_bound(value)};
+    }
+
+    /** @brief Returns the comparison object. */
+    Compare key_comp() const { return comp_; }
+
+    /** @brief Returns the comparison object. */
+    Compare value_comp() const { return comp_; }
+
+    /** @brief Checks whether two snapshots hold the same elements. */
+    bool operator==(const FrozenBST& other) const {
+        return size_ == other.size_ &&
+               std::equal(data_, data_ + size_, other.data_);
+    }
+
+    /** @brief Checks whether two snapshots differ. */
+    bool operator!=(const FrozenBST& other) const { return !(*this == other); }
+};
@@ -0,0 +1,391 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Persistent (immutable, path-copying) AVL multiset.
+ *
+ * Nodes are never modified once built. An update copies only the nodes on
+ * the search path, O(log n) of them, and shares every untouched subtree
+ * with the previous version through reference counting. Copying a tree, or
+ * taking snapshot(), is therefore O(1), and every copy is an independent
+ * version that later updates of the others do not affect. Versions may be
+ * read from several threads at once; each handle itself is not
+ * synchronised.
+ * @tparam T Type of the elements (copied into each path copy).
+ * @tparam Compare Comparison functor for ordering.
+ * @tparam Alloc Allocator used for the shared nodes.
+ */
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+class PersistentBST {
+   private:
+    struct PersistentNode;
+    using node_ptr = std::shared_ptr<const PersistentNode>;
+
+    /** @brief Immutable tree node with its subtree height and size. */
+    struct PersistentNode {
+        T data_;
+        node_ptr left_;
+        node_ptr right_;
+        size_t size_;
+        int height_;
+
+        template <class V>
+        PersistentNode(V&& data, node_ptr left, node_ptr right)
+            : data_(std::forward<V>(data)),
+              left_(std::move(left)),
+              right_(std::move(right)),
+              size_(1 + SizeOf(left_) + SizeOf(right_)),
+              height_(1 + std::max(Height(left_), Height(right_))) {}
+    };
+
+    /**
+     * @brief Forward In-order iterator keeping the path from the root.
+     *
+     * Stays valid while the version it was obtained from is alive.
+     */
+    class Iterator {
+        friend class PersistentBST;
+
+       private:
+        std::vector<const PersistentNode*> path_;
+
+        /** @brief Pushes a node and its chain of left descendants. */
+        void PushLeft(const PersistentNode* node) {
+            for (; node != nullptr; node = node->left_.get()) {
+                path_.push_back(node);
+            }
+        }
+
+       public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator() = default;
+
+        /** @brief Dereference operator to access the element. */
+        reference operator*() const { return path_.back()->data_; }
+
+        /** @brief Member access to the element. */
+        pointer operator->() const { return &path_.back()->data_; }
+
+        /** @brief Pre-increment operator. */
+        Iterator& operator++() {
+            const PersistentNode* node = path_.back();
+            path_.pop_back();
+            PushLeft(node->right_.get());
+            return *this;
+        }
+
+        /** @brief Post-increment operator. */
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        /** @brief Equality comparison. */
+        bool operator==(const Iterator& other) const {
+            if (path_.empty() || other.path_.empty()) {
+                return path_.empty() == other.path_.empty();
+            }
+            return path_.back() == other.path_.back();
+        }
+
+        /** @brief Inequality comparison. */
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    using node_allocator_type = typename std::allocator_traits<
+        Alloc>::template rebind_alloc<PersistentNode>;
+
+    node_ptr root_;
+    Compare comp_;
+    node_allocator_type alloc_;
+
+    /** @brief Returns the height of a (possibly null) subtree. */
+    static int Height(const node_ptr& node) {
+        return node != nullptr ? node->height_ : 0;
+    }
+
+    /** @brief Returns the size of a (possibly null) subtree. */
+    static size_t SizeOf(const node_ptr& node) {
+        return node != nullptr ? node->size_ : 0;
+    }
+
+    /** @brief Allocates a fresh node sharing the given subtrees. */
+    template <class V>
+    node_ptr MakeNode(V&& data, node_ptr left, node_ptr right) const {
+        return std::allocate_shared<PersistentNode>(
+            alloc_, std::forward<V>(data), std::move(left), std::move(right));
+    }
+
+    /**
+     * @brief Builds a node over two subtrees whose heights differ by at most
+     * two, rotating (by building new nodes) to restore the AVL balance.
+     */
+    template <class V>
+    node_ptr Balance(V&& data, node_ptr left, node_ptr right) const {
+        if (Height(left) > Height(right) + 1) {
+            if (Height(left->left_) >= Height(left->right_)) {
+                return MakeNode(left->data_, left->left_,
+                                MakeNode(std::forward<V>(data), left->right_,
+                                         std::move(right)));
+            }
+            const node_ptr& pivot = left->right_;
+            return MakeNode(pivot->data_,
+                            MakeNode(left->data_, left->left_, pivot->left_),
+                            MakeNode(std::forward<V>(data), pivot->right_,
+                                     std::move(right)));
+        }
+        if (Height(right) > Height(left) + 1) {
+            if (Height(right->right_) >= Height(right->left_)) {
+                return MakeNode(right->data_,
+                                MakeNode(std::forward<V>(data), std::move(left),
+                                         right->left_),
+                                right->right_);
+            }
+            const node_ptr& pivot = right->left_;
+            return MakeNode(pivot->data_,
+                            MakeNode(std::forward<V>(data), std::move(left),
+                                     pivot->left_),
+                            MakeNode(right->data_, pivot->right_, right->right_));
+        }
+        return MakeNode(std::forward<V>(data), std::move(left), std::move(right));
+    }
+
+    /**
+     * @brief Returns a new version of a subtree with the value inserted at
+     * its upper-bound position.
+     */
+    template <class V>
+    node_ptr Insert(const node_ptr& node, V&& value) const {
+        if (node == nullptr) {
+            return MakeNode(std::forward<V>(value), nullptr, nullptr);
+        }
+        if (comp_(value, node->data_)) {
+            return Balance(node->data_, Insert(node->left_, std::forward<V>(value)),
+                           node->right_);
+        }
+        return Balance(node->data_, node->left_,
+                       Insert(node->right_, std::forward<V>(value)));
+    }
+
+    /**
+     * @brief Returns a subtree without its minimum.
+     * @param min Receives the removed minimum node.
+     */
+    node_ptr RemoveMin(const node_ptr& node, const PersistentNode*& min) const {
+        if (node->left_ == nullptr) {
+            min = node.get();
+            return node->right_;
+        }
+        return Balance(node->data_, RemoveMin(node->left_, min), node->right_);
+    }
+
+    /**
+     * @brief Returns a subtree with one element equal to the value removed.
+     * @param removed Set to true if an element was found.
+     */
+    node_ptr EraseOne(const node_ptr& node, const T& value, bool& removed) const {
+        if (node == nullptr) {
+            return nullptr;
+        }
+        if (comp_(value, node->data_)) {
+            node_ptr left = EraseOne(node->left_, value, removed);
+            return removed ? Balance(node->data_, std::move(left), node->right_)
+                           : node;
+        }
+        if (comp_(node->data_, value)) {
+            node_ptr right = EraseOne(node->right_, value, removed);
+            return removed ? Balance(node->data_, node->left_, std::move(right))
+                           : node;
+        }
+        removed = true;
+        if (node->left_ == nullptr) {
+            return node->right_;
+        }
+        if (node->right_ == nullptr) {
+            return node->left_;
+        }
+        const PersistentNode* min = nullptr;
+        node_ptr right = RemoveMin(node->right_, min);
+        return Balance(min->data_, node->left_, std::move(right));
+    }
+
+    /** @brief Descends to the first node not less than the value. */
+    template <class K>
+    Iterator LowerBound(const K& value) const {
+        Iterator it;
+        for (const PersistentNode* node = root_.get(); node != nullptr;) {
+            if (comp_(node->data_, value)) {
+                node = node->right_.get();
+            } else {
+                it.path_.push_back(node);
+                node = node->left_.get();
+            }
+        }
+        return it;
+    }
+
+   public:
+    using value_type = T;
+    using key_type = T;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using allocator_type = Alloc;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    /** @brief Default constructor. Creates an empty tree. */
+    PersistentBST() = default;
+
+    /** @brief Constructs a tree from a range of elements. */
+    template <class InputIt>
+    PersistentBST(InputIt first, InputIt last) {
+        insert(first, last);
+    }
+
+    /** @brief Constructs a tree from an initializer list. */
+    PersistentBST(std::initializer_list<T> il) { insert(il.begin(), il.end()); }
+
+    /** @brief Returns an O(1) snapshot sharing all nodes with this version. */
+    PersistentBST snapshot() const { return *this; }
+
+    /** @brief Returns an iterator to the smallest element. */
+    Iterator begin() const {
+        Iterator it;
+        it.PushLeft(root_.get());
+        return it;
+    }
+
+    /** @brief Returns the past-the-end iterator. */
+    Iterator end() const { return Iterator(); }
+
+    /** @brief Returns a constant iterator to the smallest element. */
+    Iterator cbegin() const { return begin(); }
+
+    /** @brief Returns the constant past-the-end iterator. */
+    Iterator cend() const { return end(); }
+
+    /** @brief Checks if the tree is empty. */
+    bool empty() const { return root_ == nullptr; }
+
+    /** @brief Returns the number of elements. */
+    size_t size() const { return SizeOf(root_); }
+
+    /** @brief Returns the height of the tree (0 when empty). */
+    int height() const { return Height(root_); }
+
+    /** @brief Removes all elements from this version. */
+    void clear() { root_.reset(); }
+
+    /** @brief Swaps contents with another version. */
+    void swap(PersistentBST& other) noexcept {
+        using std::swap;
+        swap(root_, other.root_);
+        swap(comp_, other.comp_);
+        swap(alloc_, other.alloc_);
+    }
+
+    /** @brief Inserts a copy of the value, path-copying O(log n) nodes. */
+    void insert(const T& value) { root_ = Insert(root_, value); }
+
+    /** @brief Inserts the value by moving it. */
+    void insert(T&& value) { root_ = Insert(root_, std::move(value)); }
+
+    /** @brief Inserts elements from a range. */
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    /**
+     * @brief Erases every element equal to the value.
+     * @return The number of elements removed.
+     */
+    size_t erase(const T& value) {
+        size_t count = 0;
+        for (bool removed = true; removed; count += removed) {
+            removed = false;
+            root_ = EraseOne(root_, value, removed);
+        }
+        return count;
+    }
+
+    /** @brief Returns an iterator to the first element equal to the value. */
+    Iterator find(const T& value) const {
+        Iterator it = LowerBound(value);
+        if (it != end() && comp_(value, *it)) {
+            return end();
+        }
+        return it;
+    }
+
+    /** @brief Checks whether an element equal to the value exists. */
+    bool contains(const T& value) const {
+        for (const PersistentNode* node = root_.get(); node != nullptr;) {
+            if (comp_(value, node->data_)) {
+                node = node->left_.get();
+            } else if (comp_(node->data_, value)) {
+                node = node->right_.get();
+            } else {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** @brief Returns the number of elements equal to the value. */
+    size_t count(const T& value) const {
+        size_t count = 0;
+        for (auto it = LowerBound(value); it != end() && !comp_(value, *it); ++it) {
+            ++count;
+        }
+        return count;
+    }
+
+    /** @brief Returns an iterator to the first element not less than the value. */
+    Iterator lower_bound(const T& value) const { return LowerBound(value); }
+
+    /** @brief Returns the comparison object. */
+    Compare key_comp() const { return comp_; }
+
+    /** @brief Returns the comparison object. */
+    Compare value_comp() const { return comp_; }
+
+    /** @brief Checks whether two versions share the same root (O(1)). */
+    bool shares_root(const PersistentBST& other) const {
+        return root_ == other.root_;
+    }
+
+    /** @brief Checks whether two versions hold the same sequence of elements. */
+    bool operator==(const PersistentBST& other) const {
+        return root_ == other.root_ ||
+               (size() == other.size() && std::equal(begin(), end(), other.begin()));
+    }
+
+    /** @brief Checks whether two versions differ. */
+    bool operator!=(const PersistentBST& other) const { return !(*this == other); }
+};
+
+/** @brief Swaps the contents of two persistent trees. */
+template <class T, class Compare, class Alloc>
+void swap(PersistentBST<T, Compare, Alloc>& lhs,
+          PersistentBST<T, Compare, Alloc>& rhs) noexcept {
+    lhs.swap(rhs);
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Chunked storage for equally sized blocks with a free list.
+ *
+ * The pool adopts the block size of its first single-object request.
+ * Blocks are carved sequentially out of large chunks, freed blocks are
+ * recycled through an intrusive free list, and release() returns every
+ * chunk at once. The pool is not thread-safe.
+ */
+class NodePool {
+   private:
+    struct FreeBlock {
+        FreeBlock* next_;
+    };
+
+    size_t block_count_;
+    size_t block_size_ = 0;
+    std::vector<void*> chunks_;
+    char* cursor_ = nullptr;
+    char* limit_ = nullptr;
+    FreeBlock* free_ = nullptr;
+    size_t in_use_ = 0;
+
+    /** @brief Rounds a size up to a multiple of the block alignment. */
+    static size_t Round(size_t size) {
+        constexpr size_t align = alignof(std::max_align_t);
+        size = size < sizeof(FreeBlock) ? sizeof(FreeBlock) : size;
+        return (size + align - 1) / align * align;
+    }
+
+   public:
+    /**
+     * @brief Creates an empty pool.
+     * @param block_count Number of blocks carved out of each chunk.
+     */
+    explicit NodePool(size_t block_count) : block_count_(block_count) {}
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    /** @brief Destructor. Returns all chunks to the system. */
+    ~NodePool() { release(); }
+
+    /**
+     * @brief Checks whether objects of a given layout are served by the pool.
+     * @param size Object size in bytes.
+     * @param align Object alignment.
+     */
+    bool fits(size_t size, size_t align) const {
+        return align <= alignof(std::max_align_t) &&
+               (block_size_ == 0 || block_size_ == Round(size));
+    }
+
+    /**
+     * @brief Hands out one block, recycling freed blocks first.
+     * @param size Object size in bytes; must satisfy fits().
+     */
+    void* allocate(size_t size) {
+        if (block_size_ == 0) {
+            block_size_ = Round(size);
+        }
+        ++in_use_;
+        if (free_ != nullptr) {
+            FreeBlock* block = free_;
+            free_ = block->next_;
+            return block;
+        }
+        if (cursor_ == limit_) {
+            chunks_.push_back(nullptr);
+            chunks_.back() = ::operator new(block_size_ * block_count_);
+            cursor_ = static_cast<char*>(chunks_.back());
+            limit_ = cursor_ + block_size_ * block_count_;
+        }
+        void* block = cursor_;
+        cursor_ += block_size_;
+        return block;
+    }
+
+    /** @brief Puts a block back on the free list. */
+    void deallocate(void* block) {
+        --in_use_;
+        FreeBlock* head = static_cast<FreeBlock*>(block);
+        head->next_ = free_;
+        free_ = head;
+    }
+
+    /** @brief Frees every chunk in O(chunks), invalidating all blocks. */
+    void release() {
+        for (void* chunk : chunks_) {
+            ::operator delete(chunk);
+        }
+        chunks_.clear();
+        cursor_ = limit_ = nullptr;
+        free_ = nullptr;
+        in_use_ = 0;
+    }
+
+    /** @brief Returns the number of bytes reserved in chunks. */
+    size_t reserved_bytes() const {
+        return chunks_.size() * block_size_ * block_count_;
+    }
+
+    /** @brief Returns the number of bytes in blocks currently handed out. */
+    size_t used_bytes() const { return in_use_ * block_size_; }
+};
+
+/**
+ * @brief Arena allocator carving single objects out of a shared NodePool.
+ *
+ * Intended as the Alloc parameter of BST: every tree node comes from a large
+ * chunk and freed nodes are reused, which cuts malloc calls and keeps nodes
+ * close together. Copies (including rebound ones) share the pool; a
+ * default-constructed allocator, and a tree copy, start a fresh one.
+ * Multi-object requests fall back to operator new.
+ * @tparam T Type of the allocated objects.
+ * @tparam BlockCount Number of objects per chunk.
+ */
+template <class T, size_t BlockCount = 1024>
+class PoolAllocator {
+    template <class U, size_t N>
+    friend class PoolAllocator;
+
+   private:
+    std::shared_ptr<NodePool> pool_;
+
+    /** @brief Checks whether a request of n objects goes through the pool. */
+    bool Pooled(size_t n) const {
+        return n == 1 && pool_->fits(sizeof(T), alignof(T));
+    }
+
+   public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    template <class U>
+    struct rebind {
+        using other = PoolAllocator<U, BlockCount>;
+    };
+
+    /** @brief Creates an allocator with its own empty pool. */
+    PoolAllocator() : pool_(std::make_shared<NodePool>(BlockCount)) {}
+
+    /** @brief Copy constructor; shares the pool (moves copy as well). */
+    PoolAllocator(const PoolAllocator& other) noexcept = default;
+    PoolAllocator& operator=(const PoolAllocator& other) noexcept = default;
+
+    /** @brief Rebinding constructor; shares the pool of the source. */
+    template <class U>
+    PoolAllocator(const PoolAllocator<U, BlockCount>& other) noexcept
+        : pool_(other.pool_) {}
+
+    /** @brief Containers copied with this allocator get a fresh pool. */
+    PoolAllocator select_on_container_copy_construction() const {
+        return PoolAllocator();
+    }
+
+    /** @brief Allocates storage for n objects. */
+    T* allocate(size_t n) {
+        if (Pooled(n)) {
+            return static_cast<T*>(pool_->allocate(sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    /** @brief Deallocates storage obtained from allocate(n). */
+    void deallocate(T* p, size_t n) noexcept {
+        if (Pooled(n)) {
+            pool_->deallocate(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    /**
+     * @brief Drops the whole arena at once if no other allocator shares it.
+     * @return True if the chunks were released.
+     */
+    bool release() {
+        if (pool_.use_count() != 1) {
+            return false;
+        }
+        pool_->release();
+        return true;
+    }
+
+    /** @brief Returns the shared pool. */
+    const NodePool& pool() const { return *pool_; }
+
+    /** @brief Allocators are equal when they share a pool. */
+    template <class U>
+    bool operator==(const PoolAllocator<U, BlockCount>& other) const {
+        return pool_ == other.pool_;
+    }
+
+    template <class U>
+    bool operator!=(const PoolAllocator<U, BlockCount>& other) const {
+        return pool_ != other.pool_;
+    }
+};
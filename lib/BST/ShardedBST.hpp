@@ -0,0 +1,410 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "BST.hpp"
+#include "PoolAllocator.hpp"
+
+/**
+ * @brief Thread-safe multiset range-partitioned over several BST shards.
+ *
+ * The keys are split by Shards - 1 sorted bounds: shard i holds the
+ * elements in [bounds[i - 1], bounds[i]). Every shard is a red-black BST
+ * with its own reader-writer lock and, with the default PoolAllocator, its
+ * own node pool, so writers to different key ranges never contend. Lookups
+ * take one shared lock and updates one exclusive lock; no lock is global.
+ * Because the shards are ordered, the In-order iterator simply walks them
+ * one after another.
+ *
+ * Iterators, and rebalance(), take no locks: they require that no other
+ * thread modifies the tree meanwhile.
+ * @tparam T Type of the elements.
+ * @tparam Compare Comparison functor for ordering.
+ * @tparam Alloc Allocator of each shard (copied per shard).
+ * @tparam Shards Number of shards.
+ */
+template <class T, class Compare = std::less<T>, class Alloc = PoolAllocator<T>,
+          size_t Shards = 16>
+class ShardedBST {
+    static_assert(Shards > 0, "ShardedBST requires at least one shard");
+
+   public:
+    using tree_type = BST<T, Compare, Alloc, RedBlack>;
+
+   private:
+    using tree_iterator = typename tree_type::const_iterator;
+    using read_lock = std::shared_lock<std::shared_mutex>;
+    using write_lock = std::unique_lock<std::shared_mutex>;
+
+    /** @brief Spacing that keeps each shard lock on its own cache line. */
+    static constexpr size_t kLine = 64;
+
+    /** @brief One key range: its tree and the lock guarding it. */
+    struct alignas(kLine) Shard {
+        mutable std::shared_mutex lock_;
+        tree_type tree_;
+    };
+
+    /**
+     * @brief Bidirectional In-order iterator across the shards.
+     *
+     * Only end() rests at the end of a shard; every other position points
+     * at an element.
+     */
+    class Iterator {
+        friend class ShardedBST;
+
+       private:
+        const ShardedBST* owner_ = nullptr;
+        size_t shard_ = 0;
+        tree_iterator it_;
+
+        Iterator(const ShardedBST* owner, size_t shard, tree_iterator it)
+            : owner_(owner), shard_(shard), it_(it) {
+            SkipExhausted();
+        }
+
+        /** @brief Returns the tree of a shard. */
+        const tree_type& Tree(size_t shard) const {
+            return owner_->shards_[shard].tree_;
+        }
+
+        /** @brief Moves from the end of a shard to the start of the next one. */
+        void SkipExhausted() {
+            while (shard_ + 1 < Shards && it_ == Tree(shard_).cend()) {
+                it_ = Tree(++shard_).cbegin();
+            }
+        }
+
+       public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        Iterator() = default;
+
+        /** @brief Dereference operator to access the element. */
+        reference operator*() const { return *it_; }
+
+        /** @brief Member access to the element. */
+        pointer operator->() const { return &*it_; }
+
+        /** @brief Pre-increment operator. */
+        Iterator& operator++() {
+            ++it_;
+            SkipExhausted();
+            return *this;
+        }
+
+        /** @brief Post-increment operator. */
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        /**
+         * @brief Pre-decrement operator.
+         *
+         * Skips back over empty shards, never past the first one.
+         */
+        Iterator& operator--() {
+            while (shard_ > 0 && it_ == Tree(shard_).cbegin()) {
+                it_ = Tree(--shard_).cend();
+            }
+            --it_;
+            return *this;
+        }
+
+        /** @brief Post-decrement operator. */
+        Iterator operator--(int) {
+            Iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        /** @brief Equality comparison. */
+        bool operator==(const Iterator& other) const {
+            return shard_ == other.shard_ && it_ == other.it_;
+        }
+
+        /** @brief Inequality comparison. */
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    std::array<Shard, Shards> shards_;
+    std::vector<T> bounds_;
+    Compare comp_;
+
+    /** @brief Returns the shard whose range holds the value. */
+    size_t ShardOf(const T& value) const {
+        return std::upper_bound(bounds_.begin(), bounds_.end(), value, comp_) -
+               bounds_.begin();
+    }
+
+    /** @brief Runs job(i) for every shard on the calling thread. */
+    template <class Job>
+    static void ForEachShard(Sequential, Job job) {
+        for (size_t i = 0; i < Shards; ++i) {
+            job(i);
+        }
+    }
+
+    /** @brief Runs job(i) for every shard, the shards spread over threads. */
+    template <class Job>
+    static void ForEachShard(Parallel policy, Job job) {
+        RunTasks(Shards, ThreadCount(policy, Shards), job);
+    }
+
+   public:
+    using value_type = T;
+    using key_type = T;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using value_compare = Compare;
+    using allocator_type = Alloc;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    /**
+     * @brief Creates an empty tree without bounds.
+     *
+     * Every key goes to the first shard until rebalance() derives bounds
+     * from the contents.
+     */
+    explicit ShardedBST(const Compare& comp = Compare()) : comp_(comp) {
+        for (Shard& shard : shards_) {
+            shard.tree_ = tree_type(comp_);
+        }
+    }
+
+    /**
+     * @brief Creates an empty tree with fixed shard bounds.
+     * @param bounds Strictly increasing bounds, at most Shards - 1 of them.
+     * @throws std::invalid_argument if there are too many bounds or they
+     * are not strictly increasing.
+     */
+    explicit ShardedBST(std::span<const T> bounds, const Compare& comp = Compare())
+        : ShardedBST(comp) {
+        if (bounds.size() >= Shards) {
+            throw std::invalid_argument("ShardedBST: too many bounds");
+        }
+        for (size_t i = 1; i < bounds.size(); ++i) {
+            if (!comp_(bounds[i - 1], bounds[i])) {
+                throw std::invalid_argument(
+                    "ShardedBST: bounds must be strictly increasing");
+            }
+        }
+        bounds_.assign(bounds.begin(), bounds.end());
+    }
+
+    ShardedBST(const ShardedBST&) = delete;
+    ShardedBST& operator=(const ShardedBST&) = delete;
+
+    /** @brief Returns an iterator to the smallest element. */
+    Iterator begin() const { return Iterator(this, 0, shards_[0].tree_.cbegin()); }
+
+    /** @brief Returns the past-the-end iterator. */
+    Iterator end() const {
+        return Iterator(this, Shards - 1, shards_[Shards - 1].tree_.cend());
+    }
+
+    /** @brief Returns a constant iterator to the smallest element. */
+    Iterator cbegin() const { return begin(); }
+
+    /** @brief Returns the constant past-the-end iterator. */
+    Iterator cend() const { return end(); }
+
+    /** @brief Inserts a copy of the value under its shard's lock. */
+    void insert(const T& value) {
+        Shard& shard = shards_[ShardOf(value)];
+        write_lock lock(shard.lock_);
+        shard.tree_.insert(value);
+    }
+
+    /** @brief Inserts the value by moving it. */
+    void insert(T&& value) {
+        Shard& shard = shards_[ShardOf(value)];
+        write_lock lock(shard.lock_);
+        shard.tree_.insert(std::move(value));
+    }
+
+    /**
+     * @brief Inserts a batch of values, locking each shard once.
+     *
+     * The batch is bucketed by shard, then each bucket is merged into its
+     * shard with BST::insert_batch. With Parallel the shards are filled
+     * concurrently.
+     * @param values The values, in any order.
+     * @param policy Sequential, or Parallel to fill shards on several threads.
+     */
+    template <class Policy = Sequential>
+    void insert_batch(std::span<const T> values, Policy policy = Policy()) {
+        std::array<std::vector<T>, Shards> buckets;
+        for (const T& value : values) {
+            buckets[ShardOf(value)].push_back(value);
+        }
+        ForEachShard(policy, [&](size_t i) {
+            if (!buckets[i].empty()) {
+                write_lock lock(shards_[i].lock_);
+                shards_[i].tree_.insert_batch(std::span<const T>(buckets[i]));
+            }
+        });
+    }
+
+    /**
+     * @brief Erases every element equal to the value.
+     * @return The number of elements removed.
+     */
+    size_t erase(const T& value) {
+        Shard& shard = shards_[ShardOf(value)];
+        write_lock lock(shard.lock_);
+        return shard.tree_.erase(value);
+    }
+
+    /** @brief Removes all elements, one shard at a time. */
+    void clear() {
+        for (Shard& shard : shards_) {
+            write_lock lock(shard.lock_);
+            shard.tree_.clear();
+        }
+    }
+
+    /** @brief Checks whether an element equal to the value exists. */
+    bool contains(const T& value) const {
+        const Shard& shard = shards_[ShardOf(value)];
+        read_lock lock(shard.lock_);
+        return shard.tree_.contains(value);
+    }
+
+    /** @brief Counts the elements equal to the value. */
+    size_t count(const T& value) const {
+        const Shard& shard = shards_[ShardOf(value)];
+        read_lock lock(shard.lock_);
+        return shard.tree_.count(value);
+    }
+
+    /**
+     * @brief Returns the number of elements.
+     *
+     * Shards are counted one after another, so the total is not a snapshot
+     * while writers run.
+     */
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < Shards; ++i) {
+            total += shard_size(i);
+        }
+        return total;
+    }
+
+    /** @brief Checks if the tree is empty. */
+    bool empty() const { return size() == 0; }
+
+    /** @brief Returns the number of elements of one shard. */
+    size_t shard_size(size_t shard) const {
+        read_lock lock(shards_[shard].lock_);
+        return shards_[shard].tree_.size();
+    }
+
+    /** @brief Returns the current shard bounds. */
+    std::span<const T> bounds() const { return bounds_; }
+
+    /**
+     * @brief Calls fn on every element in In-order, holding each shard's
+     * shared lock while it is visited.
+     * @param fn Callable taking const T&.
+     */
+    template <class Fn>
+    void for_each(Fn fn) const {
+        for (const Shard& shard : shards_) {
+            read_lock lock(shard.lock_);
+            shard.tree_.for_each(std::ref(fn));
+        }
+    }
+
+    /**
+     * @brief Calls fn on every element in In-order on the calling thread.
+     * @param fn Callable taking const T&, invoked by reference.
+     */
+    template <class Fn>
+    void parallel_for_each(Sequential, Fn&& fn) const {
+        for_each(std::ref(fn));
+    }
+
+    /**
+     * @brief Calls fn on every element, visiting the shards concurrently.
+     *
+     * Every shard calls the same fn through a reference, as std::for_each
+     * with std::execution::par does, so state kept in fn survives the call
+     * but fn must tolerate concurrent calls.
+     * @param policy Thread count.
+     * @param fn Callable taking const T&.
+     */
+    template <class Fn>
+    void parallel_for_each(Parallel policy, Fn&& fn) const {
+        ForEachShard(policy, [&](size_t i) {
+            read_lock lock(shards_[i].lock_);
+            shards_[i].tree_.for_each(std::ref(fn));
+        });
+    }
+
+    /**
+     * @brief Moves the bounds to the quantiles of the contents so that the
+     * shards hold about the same number of elements.
+     *
+     * Every shard is rebuilt from the sorted elements in O(n). Keys equal
+     * to a bound all go to the later shard, so heavy duplicates may leave
+     * fewer than Shards - 1 bounds. The new shards are built aside and
+     * swapped in at the end, so a throw leaves the tree unchanged. Must not
+     * run concurrently with any other member call.
+     */
+    void rebalance() {
+        std::vector<T> sorted;
+        sorted.reserve(size());
+        for (const Shard& shard : shards_) {
+            shard.tree_.for_each([&](const T& value) { sorted.push_back(value); });
+        }
+        std::vector<T> bounds;
+        for (size_t i = 1; i < Shards && !sorted.empty(); ++i) {
+            const T& bound = sorted[i * sorted.size() / Shards];
+            if (comp_(sorted.front(), bound) &&
+                (bounds.empty() || comp_(bounds.back(), bound))) {
+                bounds.push_back(bound);
+            }
+        }
+        std::array<tree_type, Shards> trees;
+        auto first = sorted.begin();
+        for (size_t i = 0; i < Shards; ++i) {
+            auto last = i < bounds.size()
+                            ? std::lower_bound(first, sorted.end(), bounds[i], comp_)
+                            : sorted.end();
+            trees[i] = tree_type(comp_);
+            trees[i].insert_sorted(first, last);
+            first = last;
+        }
+        for (size_t i = 0; i < Shards; ++i) {
+            shards_[i].tree_.swap(trees[i]);
+        }
+        bounds_ = std::move(bounds);
+    }
+
+    /** @brief Returns the comparison object. */
+    Compare key_comp() const { return comp_; }
+
+    /** @brief Returns the comparison object. */
+    Compare value_comp() const { return comp_; }
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+/**
+ * @brief Element order of a snapshot file.
+ */
+enum class SnapshotLayout : uint32_t {
+    Sorted = 0,     ///< In-order sequence, written by BST::save.
+    Eytzinger = 1,  ///< Breadth-first order, written by FrozenBST::save.
+};
+
+/**
+ * @brief Fixed 64-byte header of the binary snapshot format.
+ *
+ * The header is followed by count_ raw elements. Files use the byte order
+ * of the machine that wrote them; byte_order_ detects a mismatch. The
+ * header size keeps the element array aligned in memory-mapped files.
+ */
+struct SnapshotHeader {
+    static constexpr char kMagic[8] = {'B', 'S', 'T', 'S', 'N', 'A', 'P', '\0'};
+    static constexpr uint32_t kByteOrder = 0x01020304;
+    static constexpr uint32_t kVersion = 1;
+
+    char magic_[8];
+    uint32_t byte_order_;
+    uint32_t version_;
+    uint32_t layout_;
+    uint32_t value_size_;
+    uint64_t count_;
+    char reserved_[32];
+
+    /** @brief Creates the header for count elements of type T. */
+    template <class T>
+    static SnapshotHeader Make(SnapshotLayout layout, uint64_t count) {
+        SnapshotHeader header{};
+        std::memcpy(header.magic_, kMagic, sizeof(kMagic));
+        header.byte_order_ = kByteOrder;
+        header.version_ = kVersion;
+        header.layout_ = static_cast<uint32_t>(layout);
+        header.value_size_ = sizeof(T);
+        header.count_ = count;
+        return header;
+    }
+
+    /**
+     * @brief Checks that the header describes elements of type T in the
+     * expected layout.
+     * @throws std::runtime_error on any mismatch.
+     */
+    template <class T>
+    void Validate(SnapshotLayout layout) const {
+        if (std::memcmp(magic_, kMagic, sizeof(kMagic)) != 0) {
+            throw std::runtime_error("snapshot: bad magic");
+        }
+        if (byte_order_ != kByteOrder || version_ != kVersion) {
+            throw std::runtime_error("snapshot: unsupported byte order or version");
+        }
+        if (value_size_ != sizeof(T)) {
+            throw std::runtime_error("snapshot: element size mismatch");
+        }
+        if (layout_ != static_cast<uint32_t>(layout)) {
+            throw std::runtime_error("snapshot: unexpected layout");
+        }
+    }
+};
+
+static_assert(sizeof(SnapshotHeader) == 64);
+
+/** @brief Writes raw bytes, throwing if the stream fails. */
+inline void WriteSnapshotBytes(std::ostream& out, const void* data, size_t size) {
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!out) {
+        throw std::runtime_error("snapshot: write failed");
+    }
+}
+
+/** @brief Reads raw bytes, throwing on a short read. */
+inline void ReadSnapshotBytes(std::istream& in, void* data, size_t size) {
+    in.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+    if (static_cast<size_t>(in.gcount()) != size) {
+        throw std::runtime_error("snapshot: truncated input");
+    }
+}
+
+/**
+ * @brief Reads and validates a snapshot header.
+ * @return The number of elements that follow.
+ */
+template <class T>
+uint64_t ReadSnapshotHeader(std::istream& in, SnapshotLayout layout) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "snapshots require a trivially copyable element type");
+    SnapshotHeader header;
+    ReadSnapshotBytes(in, &header, sizeof(header));
+    header.Validate<T>(layout);
+    return header.count_;
+}
@@ -1,7 +1,26 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <set>
 #include <sstream>
+#include <string_view>
+#include <thread>
 #include <vector>
 #include "BST.hpp"
+#include "BTreeBST.hpp"
+#include "CompactBST.hpp"
+#include "ConcurrentBST.hpp"
+#include "FrozenBST.hpp"
+#include "PersistentBST.hpp"
+#include "PoolAllocator.hpp"
+#include "ShardedBST.hpp"
 
 /**
  * @brief Tests the empty() method for both new and populated trees.
@@ -63,6 +82,49 @@ TEST(BST, insert) {
     EXPECT_EQ(expected, actual);
 }
 
+/**
+ * @brief Tests all traversal orders in both directions on single-child shapes.
+ */
+TEST(BST, traversal_orders) {
+    BST<int> empty;
+    EXPECT_EQ(empty.begin(Preorder()), empty.end(Preorder()));
+    EXPECT_EQ(empty.begin(Postorder()), empty.end(Postorder()));
+
+    // 5 has only a left child and 1 only a right one.
+    BST<int> bst = {5, 1, 3, 2, 4, 8, 7, 9};
+    auto walk = [&](auto pick) {
+        std::string forward;
+        for (auto i = bst.begin(pick); i != bst.end(pick); ++i) {
+            forward += ' ' + std::to_string(*i);
+        }
+        std::string backward;
+        for (auto i = bst.end(pick); i != bst.begin(pick);) {
+            backward = ' ' + std::to_string(*--i) + backward;
+        }
+        EXPECT_EQ(forward, backward);
+        return forward;
+    };
+    EXPECT_EQ(walk(Inorder()), " 1 2 3 4 5 7 8 9");
+    EXPECT_EQ(walk(Preorder()), " 5 1 3 2 4 8 7 9");
+    EXPECT_EQ(walk(Postorder()), " 2 4 3 1 7 9 8 5");
+
+    BST<int> chain;
+    chain.insert(1);
+    chain.insert(2);
+    chain.insert(3);
+    EXPECT_EQ(*++chain.begin(Preorder()), 2);
+    EXPECT_EQ(*chain.begin(Postorder()), 3);
+
+    // A left chain deeper than the scan stack.
+    BST<int> deep;
+    for (int i = 1000; i > 0; --i) {
+        deep.insert(i);
+    }
+    int expected = 1;
+    deep.for_each([&](int value) { EXPECT_EQ(value, expected++); });
+    EXPECT_EQ(expected, 1001);
+}
+
 /**
  * @brief Tests range insertion using iterator pairs from another container.
  */
@@ -79,6 +141,20 @@ TEST(BST, insert_it) {
         actual += ' ' + std::to_string(*i);
     }
     EXPECT_EQ(expected, actual);
+
+    // Only an empty tree builds a sorted range in one pass; a populated
+    // one links the elements one by one instead of rebuilding
+    BST<int, std::less<int>, std::allocator<int>, RedBlack, NoAugment, CollectStats>
+        counted;
+    std::vector<int> more(50);
+    std::iota(more.begin(), more.end(), 8);
+    counted.insert(more.begin(), more.begin() + 10);
+    EXPECT_EQ(counted.stats().rebuilds_, 1);
+    counted.insert(more.begin() + 10, more.end());
+    EXPECT_EQ(counted.stats().rebuilds_, 1);
+    EXPECT_EQ(counted.stats().inserts_, 40);
+    EXPECT_EQ(counted.size(), 50);
+    EXPECT_TRUE(counted.validate());
 }
 
 /**
@@ -195,8 +271,9 @@ TEST(BST, contains) {
 TEST(BST, extract) {
     BST<int> bst;
     bst.insert(5);
-    EXPECT_EQ(bst.extract(5), 5); // Should return 5
-    EXPECT_TRUE(bst.empty());     // Tree should be empty after extraction
+    EXPECT_EQ(bst.extract(5).value(), 5); // Should return 5
+    EXPECT_TRUE(bst.empty());             // Tree should be empty after extraction
+    EXPECT_TRUE(bst.extract(5).empty());  // Absent values give an empty handle
 }
 
 /**
@@ -210,6 +287,142 @@ TEST(BST, swap) {
     EXPECT_EQ(bst2, bst1);
 }
 
+/**
+ * @brief Allocator that never propagates and only equals itself by id.
+ */
+template <class T>
+struct TaggedAllocator : std::allocator<T> {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::false_type;
+    using is_always_equal = std::false_type;
+    template <class U>
+    struct rebind {
+        using other = TaggedAllocator<U>;
+    };
+
+    int id_ = 0;
+
+    TaggedAllocator() = default;
+    explicit TaggedAllocator(int id) : id_(id) {}
+    template <class U>
+    TaggedAllocator(const TaggedAllocator<U>& other) : id_(other.id_) {}
+
+    template <class U>
+    bool operator==(const TaggedAllocator<U>& other) const {
+        return id_ == other.id_;
+    }
+};
+
+/**
+ * @brief Comparator whose move assignment may throw.
+ */
+struct ThrowingMoveLess : std::less<int> {
+    ThrowingMoveLess() = default;
+    ThrowingMoveLess(const ThrowingMoveLess&) = default;
+    ThrowingMoveLess& operator=(const ThrowingMoveLess&) = default;
+    ThrowingMoveLess& operator=(ThrowingMoveLess&&) noexcept(false) { return *this; }
+};
+
+/**
+ * @brief Tests O(1) moves, the element-wise move fallback and a full swap.
+ */
+TEST(BST, move_semantics) {
+    static_assert(std::is_nothrow_move_constructible_v<BST<int>>);
+    static_assert(std::is_nothrow_move_assignable_v<BST<int>>);
+    static_assert(!std::is_nothrow_move_assignable_v<BST<int, std::less<int>, TaggedAllocator<int>>>);
+    static_assert(!std::is_nothrow_move_assignable_v<BST<int, ThrowingMoveLess>>);
+
+    BST<int> source = {4, 2, 6, 1, 3, 5, 7};
+    const int* element = &*source.find(3);
+    BST<int> moved(std::move(source));
+    EXPECT_EQ(&*moved.find(3), element); // Nodes changed owner, not copied
+    EXPECT_EQ(moved.size(), 7);
+    EXPECT_TRUE(source.empty());
+    EXPECT_EQ(source.size(), 0);
+    source.insert(10); // The moved-from tree stays usable
+    EXPECT_EQ(*source.begin(), 10);
+
+    BST<int> target = {100, 200};
+    target = std::move(moved);
+    EXPECT_EQ(&*target.find(3), element);
+    EXPECT_EQ(*--target.end(), 7);
+    EXPECT_TRUE(moved.empty());
+
+    std::vector<BST<int>> trees;
+    for (int i = 0; i < 20; ++i) {
+        trees.push_back(BST<int>{i, i + 1});
+    }
+    EXPECT_EQ(*trees[19].begin(), 19);
+
+    BST<int, std::less<int>, TaggedAllocator<int>> left = {1, 2, 3};
+    BST<int, std::less<int>, TaggedAllocator<int>> right;
+    right = std::move(left); // Equal allocators: the nodes are stolen
+    EXPECT_EQ(right.size(), 3);
+    BST<int, std::less<int>, TaggedAllocator<int>> other{TaggedAllocator<int>(1)};
+    other.insert(9);
+    right = std::move(other); // Unequal allocators: elements are moved
+    EXPECT_EQ(right.size(), 1);
+    EXPECT_EQ(*right.begin(), 9);
+    EXPECT_TRUE(other.empty());
+
+    BST<int, std::greater<int>> high = {1, 2, 3};
+    BST<int, std::greater<int>> low = {5};
+    high.swap(low);
+    EXPECT_EQ(high.size(), 1);
+    EXPECT_EQ(low.size(), 3);
+    EXPECT_EQ(*low.begin(), 3);
+    low.insert(4);
+    EXPECT_EQ(*low.begin(), 4);
+    EXPECT_EQ(*--high.end(), 5);
+}
+
+/**
+ * @brief Tests moving and re-keying nodes through node handles.
+ */
+TEST(BST, node_handles) {
+    using Tree = BST<std::string, std::less<std::string>, std::allocator<std::string>,
+                     RedBlack, SubtreeSize>;
+    Tree source = {"apple", "banana", "cherry"};
+    Tree target = {"kiwi"};
+    const std::string* storage = &*source.find("banana");
+
+    Tree::node_type handle = source.extract("banana");
+    ASSERT_FALSE(handle.empty());
+    EXPECT_EQ(source.size(), 2);
+    EXPECT_TRUE(source.validate());
+    auto it = target.insert(std::move(handle));
+    EXPECT_TRUE(handle.empty());
+    EXPECT_EQ(&*it, storage); // Same node, no reallocation
+    EXPECT_EQ(target.size(), 2);
+    EXPECT_TRUE(target.validate());
+
+    // Re-keying in place: extract, change the value, reinsert.
+    handle = target.extract(target.find("kiwi"));
+    handle.value() = "aardvark";
+    it = target.insert(target.begin(), std::move(handle));
+    EXPECT_EQ(*it, "aardvark");
+    EXPECT_EQ(*target.begin(), "aardvark");
+    EXPECT_EQ(*target.nth(1), "banana");
+    EXPECT_TRUE(target.validate());
+
+    // Handles own their node until inserted, and empty ones insert nothing.
+    Tree::node_type dropped = source.extract(source.begin());
+    EXPECT_EQ(dropped.value(), "apple");
+    EXPECT_EQ(target.insert(Tree::node_type()), target.end());
+    Tree::node_type moved = std::move(dropped);
+    EXPECT_TRUE(dropped.empty());
+    swap(moved, dropped);
+    EXPECT_EQ(dropped.value(), "apple");
+
+    // Unequal allocators fall back to moving the value into a new node.
+    BST<int, std::less<int>, TaggedAllocator<int>> left(TaggedAllocator<int>(1));
+    BST<int, std::less<int>, TaggedAllocator<int>> right(TaggedAllocator<int>(2));
+    left.insert(7);
+    right.insert(left.extract(7));
+    EXPECT_TRUE(left.empty());
+    EXPECT_EQ(*right.begin(), 7);
+}
+
 /**
  * @brief Tests merging one tree into another.
  */
@@ -247,4 +460,1284 @@ TEST(BST, equal_range) {
     auto [e, f] = bst.equal_range(3, Postorder());
     EXPECT_EQ(*e, 3);
     EXPECT_EQ(*f, 2);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Tests that the red-black policy keeps sorted input balanced.
+ */
+TEST(BST, red_black_insert) {
+    BST<int, std::less<int>, std::allocator<int>, RedBlack> bst;
+    for (int i = 1; i <= 7; ++i) {
+        bst.insert(i);
+    }
+
+    // Sorted insertion must not degrade into a chain
+    std::string expected = " 2 1 4 3 6 5 7";
+    std::string actual;
+    for (auto i = bst.begin(Preorder()); i != bst.end(Preorder()); ++i) {
+        actual += ' ' + std::to_string(*i);
+    }
+    EXPECT_EQ(expected, actual);
+}
+
+/**
+ * @brief Tests red-black erase and extract against std::multiset.
+ */
+TEST(BST, red_black_erase) {
+    BST<int, std::less<int>, std::allocator<int>, RedBlack> bst;
+    std::multiset<int> reference;
+    for (int i = 0; i < 2000; ++i) {
+        int value = (i * 7919) % 503;
+        bst.insert(value);
+        reference.insert(value);
+    }
+    for (int i = 0; i < 503; i += 3) {
+        EXPECT_EQ(bst.erase(i), reference.erase(i));
+    }
+    EXPECT_EQ(bst.extract(bst.begin()).value(), *reference.begin());
+    reference.erase(reference.begin());
+
+    EXPECT_EQ(bst.size(), reference.size());
+    EXPECT_TRUE(std::equal(bst.cbegin(), bst.cend(), reference.begin()));
+}
+
+/**
+ * @brief Tests lower_bound()/upper_bound() for present and absent keys.
+ */
+TEST(BST, bounds) {
+    BST<int> bst = {10, 20, 20, 30, 40};
+
+    EXPECT_EQ(*bst.lower_bound(20), 20);
+    EXPECT_EQ(*bst.upper_bound(20), 30);
+    EXPECT_EQ(*bst.lower_bound(25), 30); // Absent key: next greater element
+    EXPECT_EQ(*bst.upper_bound(25), 30);
+    EXPECT_EQ(bst.lower_bound(5), bst.begin());
+    EXPECT_EQ(bst.lower_bound(45), bst.end());
+    EXPECT_EQ(bst.upper_bound(40), bst.end());
+    EXPECT_EQ(bst.count(20), 2);
+    EXPECT_EQ(bst.count(25), 0);
+}
+
+/**
+ * @brief Tests range() views and std::ranges algorithms over iterators.
+ */
+TEST(BST, range_views) {
+    static_assert(std::bidirectional_iterator<BST<int>::iterator>);
+    static_assert(std::bidirectional_iterator<BST<int>::const_iterator>);
+    static_assert(std::ranges::bidirectional_range<BST<int>>);
+    static_assert(std::ranges::bidirectional_range<const BST<int>>);
+    static_assert(std::ranges::view<decltype(BST<int>().range(0, 1))>);
+
+    BST<int, std::less<int>, std::allocator<int>, RedBlack> bst;
+    for (int i = 0; i < 100; ++i) {
+        bst.insert(i * 37 % 100);
+    }
+    bst.insert(50);
+    auto view = bst.range(40, 60);
+    EXPECT_EQ(std::ranges::distance(view), 21);
+    EXPECT_EQ(view.front(), 40);
+    EXPECT_EQ(view.back(), 59);
+    EXPECT_TRUE(std::ranges::is_sorted(view));
+
+    auto odd_squares = bst.range(10, 20) | std::views::filter([](int x) { return x % 2; }) |
+                       std::views::transform([](int x) { return x * x; });
+    std::vector<int> squares(odd_squares.begin(), odd_squares.end());
+    EXPECT_EQ(squares, (std::vector<int>{121, 169, 225, 289, 361}));
+
+    std::vector<int> reversed;
+    std::ranges::copy(bst.range(95, 1000) | std::views::reverse, std::back_inserter(reversed));
+    EXPECT_EQ(reversed, (std::vector<int>{99, 98, 97, 96, 95}));
+
+    // Writes through the view reach the tree, and the bounds are half-open.
+    for (int& x : bst.range(0, 1)) {
+        x = -1;
+    }
+    EXPECT_EQ(*bst.begin(), -1);
+    EXPECT_TRUE(bst.range(60, 40).empty());
+    EXPECT_TRUE(bst.range(200, 300).empty());
+    const auto& view_of = bst;
+    EXPECT_EQ(std::ranges::distance(view_of.range(-5, 5)), 5);
+    EXPECT_EQ(*std::ranges::find(view_of, 42), 42);
+    EXPECT_EQ(*std::prev(bst.end()), 99);
+}
+
+/**
+ * @brief Tests that lookups only rely on the comparator (no operator==).
+ */
+TEST(BST, find_comparator_only) {
+    struct Key {
+        int value;
+    };
+    struct KeyLess {
+        bool operator()(const Key& lhs, const Key& rhs) const {
+            return lhs.value < rhs.value;
+        }
+    };
+    BST<Key, KeyLess> bst = {{3}, {1}, {2}};
+    EXPECT_EQ((*bst.find(Key{2})).value, 2);
+    EXPECT_EQ(bst.find(Key{4}), bst.end());
+    EXPECT_TRUE(bst.contains(Key{1}));
+    EXPECT_EQ(bst.count(Key{3}), 1);
+}
+
+/**
+ * @brief Tests that the branchless descents for arithmetic keys under
+ * std::less agree with the generic comparator path.
+ */
+TEST(BST, arithmetic_descent) {
+    struct IntLess {
+        bool operator()(int lhs, int rhs) const { return lhs < rhs; }
+    };
+    BST<int, std::less<int>, std::allocator<int>, RedBlack, SubtreeSize> fast;
+    BST<int, IntLess, std::allocator<int>, RedBlack, SubtreeSize> generic;
+    for (int i = 0; i < 2000; ++i) {
+        int value = (i * 7919) % 503 - 250;
+        fast.insert(value);
+        generic.insert(value);
+    }
+    for (int value = -260; value < 260; value += 3) {
+        auto lower = fast.lower_bound(value);
+        auto upper = fast.upper_bound(value);
+        EXPECT_EQ(std::distance(fast.begin(), lower),
+                  std::distance(generic.begin(), generic.lower_bound(value)));
+        EXPECT_EQ(std::distance(fast.begin(), upper),
+                  std::distance(generic.begin(), generic.upper_bound(value)));
+        EXPECT_EQ(fast.find(value), fast.contains(value) ? lower : fast.end());
+        EXPECT_EQ(fast.rfind(value),
+                  fast.contains(value) ? std::prev(upper) : fast.end());
+        EXPECT_EQ(fast.count(value), generic.count(value));
+        EXPECT_EQ(fast.rank(value), generic.rank(value));
+    }
+    EXPECT_TRUE(fast.validate());
+
+    BST<double> real = {2.5, -1.0, 2.5, 0.0};
+    EXPECT_EQ(*real.lower_bound(1.0), 2.5);
+    EXPECT_EQ(real.count(2.5), 2);
+    EXPECT_EQ(real.upper_bound(2.5), real.end());
+}
+
+/**
+ * @brief Tests heterogeneous lookups through a transparent comparator.
+ */
+TEST(BST, transparent_lookup) {
+    BST<std::string, std::less<>> bst = {"alpha", "beta", "beta", "gamma"};
+    std::string_view key = "beta";
+
+    EXPECT_EQ(*bst.find(key), "beta");
+    EXPECT_EQ(bst.find(std::string_view("delta")), bst.end());
+    EXPECT_EQ(*bst.find(std::string("alpha")), "alpha");
+    EXPECT_TRUE(bst.contains(key));
+    EXPECT_EQ(bst.count(key), 2);
+    EXPECT_EQ(*bst.lower_bound(std::string_view("c")), "gamma");
+    auto [low, high] = bst.equal_range(key);
+    EXPECT_EQ(*low, "beta");
+    EXPECT_EQ(*high, "gamma");
+}
+
+/**
+ * @brief Tests emplace() and rvalue insert() with a move-only type.
+ */
+TEST(BST, emplace) {
+    struct Less {
+        bool operator()(const std::unique_ptr<int>& lhs,
+                        const std::unique_ptr<int>& rhs) const {
+            return *lhs < *rhs;
+        }
+    };
+    BST<std::unique_ptr<int>, Less> bst;
+    bst.emplace(new int(2));
+    bst.insert(std::make_unique<int>(1));
+    auto [it, inserted] = bst.emplace(std::make_unique<int>(3));
+    EXPECT_TRUE(inserted);
+    EXPECT_EQ(**it, 3);
+
+    std::string expected = " 1 2 3";
+    std::string actual;
+    for (auto i = bst.begin(); i != bst.end(); ++i) {
+        actual += ' ' + std::to_string(**i);
+    }
+    EXPECT_EQ(expected, actual);
+}
+
+/**
+ * @brief Tests emplace_hint() with correct and incorrect hints.
+ */
+TEST(BST, emplace_hint) {
+    BST<int> bst;
+    auto hint = bst.end();
+    for (int i = 0; i < 5; ++i) {
+        hint = bst.emplace_hint(bst.end(), i); // Appending at the end
+    }
+    EXPECT_EQ(*hint, 4);
+
+    bst.emplace_hint(bst.find(3), 3); // Correct hint: just before 3
+    bst.emplace_hint(bst.begin(), 10); // Wrong hint: finger search from it
+
+    std::string expected = " 0 1 2 3 3 4 10";
+    std::string actual;
+    for (auto i = bst.begin(); i != bst.end(); ++i) {
+        actual += ' ' + std::to_string(*i);
+    }
+    EXPECT_EQ(expected, actual);
+    EXPECT_EQ(bst.size(), 7);
+}
+
+/**
+ * @brief Tests find_from() and insert(hint, value) from near and far hints.
+ */
+TEST(BST, finger_search) {
+    using Tree = BST<int, std::less<int>, std::allocator<int>, RedBlack,
+                     NoAugment, CollectStats>;
+    Tree bst;
+    std::multiset<int> reference;
+    auto hint = bst.end();
+    for (int i = 0; i < 4000; ++i) {
+        int value = i / 2 + (i % 7 == 0 ? 500 : 0); // Mostly near the last one
+        hint = bst.insert(hint, value);
+        EXPECT_EQ(*hint, value);
+        reference.insert(value);
+    }
+    EXPECT_TRUE(bst.validate());
+    EXPECT_TRUE(std::equal(reference.begin(), reference.end(), bst.begin()));
+
+    hint = bst.begin();
+    for (int value = -1; value < 2600; ++value) {
+        auto found = bst.find_from(hint, value);
+        EXPECT_EQ(found, bst.find(value));
+        if (found != bst.end()) {
+            hint = found;
+        }
+    }
+    const Tree& view = bst;
+    EXPECT_EQ(view.find_from(view.cend(), 0), view.cbegin());
+    EXPECT_EQ(view.find_from(view.cbegin(), 1999), view.find(1999));
+    Tree empty;
+    EXPECT_EQ(empty.find_from(empty.end(), 1), empty.end());
+
+    // A nearby key is reached in far fewer steps than from the root.
+    auto middle = bst.find(1000);
+    bst.reset_stats();
+    middle = bst.find_from(middle, 1001);
+    EXPECT_EQ(*middle, 1001);
+    EXPECT_LT(bst.stats().comparisons_, bst.height() / 2);
+
+    bst.insert(middle, 1001); // Correct hint: just before the first 1001
+    EXPECT_EQ(bst.count(1001), reference.count(1001) + 1);
+    EXPECT_TRUE(bst.validate());
+}
+
+/**
+ * @brief Tests that PoolAllocator recycles freed blocks and serves a BST.
+ */
+TEST(BST, pool_allocator) {
+    PoolAllocator<int> alloc;
+    int* first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+    EXPECT_EQ(alloc.allocate(1), first); // Freed block is reused
+
+    BST<int, std::less<int>, PoolAllocator<int>> bst = {4, 2, 6, 1, 3, 5, 7};
+    bst.erase(4);
+    bst.insert(8);
+    BST<int, std::less<int>, PoolAllocator<int>> copy = bst;
+    EXPECT_NE(copy.get_allocator(), bst.get_allocator()); // Copies own a pool
+
+    std::string expected = " 1 2 3 5 6 7 8";
+    std::string actual;
+    for (auto i = copy.begin(); i != copy.end(); ++i) {
+        actual += ' ' + std::to_string(*i);
+    }
+    EXPECT_EQ(expected, actual);
+
+    // clear() drops the whole arena and the tree stays usable
+    bst.clear();
+    EXPECT_TRUE(bst.empty());
+    bst.insert(1);
+    EXPECT_EQ(*bst.begin(), 1);
+}
+
+/**
+ * @brief Tests memory_usage() and compact() after erase churn.
+ */
+TEST(BST, compact_nodes) {
+    BST<int, std::less<int>, PoolAllocator<int>, RedBlack> bst;
+    for (int i = 0; i < 4096; ++i) {
+        bst.insert(i * 7919 % 4096);
+    }
+    for (int i = 0; i < 4096; ++i) {
+        if (i % 4 != 0) {
+            bst.erase(i);
+        }
+    }
+    auto churned = bst.memory_usage();
+    EXPECT_GT(churned.overhead_bytes(), churned.node_bytes_);
+
+    auto allocator = bst.get_allocator();
+    bst.compact();
+    EXPECT_TRUE(bst.validate());
+    EXPECT_NE(bst.get_allocator(), allocator); // Nodes moved to a fresh pool
+    auto compacted = bst.memory_usage();
+    EXPECT_EQ(compacted.node_bytes_, churned.node_bytes_);
+    EXPECT_LT(compacted.allocated_bytes_, churned.allocated_bytes_ / 2);
+
+    // The 1024 survivors fill one chunk of the new pool in In-order
+    int expected = 0;
+    const int* previous = nullptr;
+    size_t ascending = 0;
+    for (const int& value : bst) {
+        EXPECT_EQ(value, expected);
+        expected += 4;
+        ascending += previous != nullptr && &value > previous;
+        previous = &value;
+    }
+    EXPECT_EQ(ascending, bst.size() - 1);
+
+    // Counters follow the nodes: one allocation and release per element
+    BST<int, std::less<int>, PoolAllocator<int>, RedBlack, NoAugment, CollectStats>
+        counted = {3, 1, 2};
+    TreeStats before = counted.stats();
+    counted.compact();
+    EXPECT_EQ(counted.stats().allocations_, before.allocations_ + 3);
+    EXPECT_EQ(counted.stats().deallocations_, before.deallocations_ + 3);
+    EXPECT_EQ(counted.stats().inserts_, 3);
+
+    BST<int> plain = {3, 1, 2};
+    plain.compact();
+    EXPECT_EQ(plain.memory_usage().overhead_bytes(), 0);
+    EXPECT_TRUE(std::ranges::equal(plain, std::vector<int>{1, 2, 3}));
+}
+
+/**
+ * @brief Tests linear-time construction from sorted input.
+ */
+TEST(BST, from_sorted) {
+    std::vector<int> sorted = {1, 2, 3, 4, 5, 6, 7};
+    auto bst = BST<int>::from_sorted(sorted.begin(), sorted.end());
+
+    // The result is perfectly balanced
+    std::string expected = " 4 2 1 3 6 5 7";
+    std::string actual;
+    for (auto i = bst.begin(Preorder()); i != bst.end(Preorder()); ++i) {
+        actual += ' ' + std::to_string(*i);
+    }
+    EXPECT_EQ(expected, actual);
+    EXPECT_EQ(bst.size(), 7);
+
+    // The initializer-list constructor detects sorted input
+    BST<int> detected = {1, 2, 3};
+    EXPECT_EQ(*detected.begin(Preorder()), 2);
+}
+
+/**
+ * @brief Tests insert_sorted() into a populated red-black tree.
+ */
+TEST(BST, insert_sorted) {
+    BST<int, std::less<int>, std::allocator<int>, RedBlack> bst;
+    std::multiset<int> reference;
+    for (int i = 0; i < 100; ++i) {
+        bst.insert((i * 37) % 100);
+        reference.insert((i * 37) % 100);
+    }
+    std::vector<int> sorted;
+    for (int i = 0; i < 300; i += 2) {
+        sorted.push_back(i);
+        reference.insert(i);
+    }
+    bst.insert_sorted(sorted.begin(), sorted.end());
+    EXPECT_EQ(bst.size(), reference.size());
+    EXPECT_TRUE(std::equal(bst.cbegin(), bst.cend(), reference.begin()));
+
+    // The rebuilt tree keeps working with the balancing policy
+    for (int i = 0; i < 300; i += 3) {
+        EXPECT_EQ(bst.erase(i), reference.erase(i));
+    }
+    EXPECT_TRUE(std::equal(bst.cbegin(), bst.cend(), reference.begin()));
+}
+
+/**
+ * @brief Tests insert_batch() with small and large, sequential and parallel
+ * batches.
+ */
+TEST(BST, insert_batch) {
+    struct FirstLess {
+        bool operator()(const std::pair<int, int>& a, const std::pair<int, int>& b) const {
+            return a.first < b.first;
+        }
+    };
+    BST<std::pair<int, int>, FirstLess, std::allocator<std::pair<int, int>>, RedBlack> bst;
+    std::multiset<std::pair<int, int>, FirstLess> reference;
+    for (int i = 0; i < 5000; ++i) {
+        bst.insert({i * 7919 % 5000, 0});
+        reference.insert({i * 7919 % 5000, 0});
+    }
+    int tag = 0;
+    for (size_t count : {10, 100, 50000}) {
+        std::vector<std::pair<int, int>> batch;
+        for (size_t i = 0; i < count; ++i) {
+            batch.emplace_back(static_cast<int>((i * 104729) % 6000), ++tag);
+        }
+        if (count == 50000) {
+            bst.insert_batch(batch, Parallel{4});
+        } else {
+            bst.insert_batch(batch);
+        }
+        reference.insert(batch.begin(), batch.end());
+        EXPECT_TRUE(bst.validate());
+        ASSERT_EQ(bst.size(), reference.size());
+        // Equal keys keep the multiset order: existing first, then batch order.
+        EXPECT_TRUE(std::equal(reference.begin(), reference.end(), bst.cbegin(),
+                               [](const auto& a, const auto& b) { return a == b; }));
+    }
+    bst.insert_batch({});
+    EXPECT_EQ(bst.size(), reference.size());
+}
+
+/**
+ * @brief Tests merging an rvalue tree by splicing its nodes.
+ */
+TEST(BST, merge_move) {
+    BST<int, std::less<int>, std::allocator<int>, RedBlack> bst1 = {1, 3, 5};
+    BST<int, std::less<int>, std::allocator<int>, RedBlack> bst2 = {2, 3, 4};
+    auto* node = &*bst2.find(4);
+    bst1.merge(std::move(bst2));
+    EXPECT_TRUE(bst2.empty());
+    EXPECT_EQ(&*bst1.find(4), node); // The node was relinked, not copied
+
+    std::string expected = " 1 2 3 3 4 5";
+    std::string actual;
+    for (auto i = bst1.begin(); i != bst1.end(); ++i) {
+        actual += ' ' + std::to_string(*i);
+    }
+    EXPECT_EQ(expected, actual);
+    EXPECT_EQ(bst1.size(), 6);
+}
+
+/**
+ * @brief Tests union_with(), intersect_with() and difference().
+ */
+TEST(BST, set_operations) {
+    const BST<int> other = {2, 2, 3, 5, 8};
+
+    BST<int> united = {1, 2, 3, 3, 5};
+    united.union_with(other);
+    std::vector<int> expected = {1, 2, 2, 3, 3, 5, 8};
+    EXPECT_TRUE(std::equal(united.cbegin(), united.cend(), expected.begin()));
+    EXPECT_EQ(united.size(), expected.size());
+
+    BST<int> common = {1, 2, 3, 3, 5};
+    common.intersect_with(other);
+    expected = {2, 3, 5};
+    EXPECT_TRUE(std::equal(common.cbegin(), common.cend(), expected.begin()));
+    EXPECT_EQ(common.size(), expected.size());
+
+    BST<int> rest = {1, 2, 3, 3, 5};
+    rest.difference(other);
+    expected = {1, 3};
+    EXPECT_TRUE(std::equal(rest.cbegin(), rest.cend(), expected.begin()));
+    EXPECT_EQ(rest.size(), expected.size());
+}
+
+/**
+ * @brief Tests copying and destroying a degenerate (chain-shaped) tree.
+ */
+TEST(BST, deep_tree) {
+    BST<int> bst;
+    for (int i = 0; i < 200000; ++i) {
+        bst.emplace_hint(bst.end(), i); // Sorted appends build a chain
+    }
+    BST<int> copy = bst;
+    EXPECT_EQ(copy.size(), bst.size());
+    EXPECT_EQ(copy, bst);
+
+    copy.clear();
+    EXPECT_TRUE(copy.empty());
+}
+
+/**
+ * @brief Tests nth(), rank() and count_range() with subtree sizes.
+ */
+TEST(BST, order_statistics) {
+    BST<int, std::less<int>, std::allocator<int>, RedBlack, SubtreeSize> bst;
+    std::multiset<int> reference;
+    for (int i = 0; i < 1000; ++i) {
+        int value = (i * 7919) % 251;
+        bst.insert(value);
+        reference.insert(value);
+    }
+    for (int i = 0; i < 251; i += 4) {
+        bst.erase(bst.find(i));
+        reference.erase(reference.find(i));
+    }
+    std::vector<int> sorted(reference.begin(), reference.end());
+    bst.insert_sorted(sorted.begin(), sorted.begin() + 300);
+    reference.insert(sorted.begin(), sorted.begin() + 300);
+
+    size_t index = 0;
+    for (int value : reference) {
+        EXPECT_EQ(*bst.nth(index++), value);
+    }
+    EXPECT_EQ(bst.nth(reference.size()), bst.end());
+    for (int value = -1; value < 253; value += 7) {
+        EXPECT_EQ(bst.rank(value),
+                  std::distance(reference.begin(), reference.lower_bound(value)));
+        EXPECT_EQ(bst.count(value), reference.count(value));
+    }
+    EXPECT_EQ(bst.count_range(10, 20),
+              std::distance(reference.lower_bound(10), reference.lower_bound(20)));
+    EXPECT_EQ(bst.count_range(20, 10), 0);
+
+    // Sizes survive copies
+    auto copy = bst;
+    EXPECT_EQ(*copy.nth(5), *bst.nth(5));
+}
+
+/**
+ * @brief Tests height(), validate() and the CollectStats counters.
+ */
+TEST(BST, tree_stats) {
+    using Chain = BST<int, std::less<int>, std::allocator<int>, Unbalanced,
+                      NoAugment, CollectStats>;
+    using Balanced = BST<int, std::less<int>, std::allocator<int>, RedBlack,
+                         SubtreeSize, CollectStats>;
+    static_assert(sizeof(BST<int>) < sizeof(Chain));
+
+    BST<int> empty;
+    EXPECT_EQ(empty.height(), 0);
+    EXPECT_TRUE(empty.validate());
+
+    // Sorted inserts degenerate into a chain without a balancing policy.
+    Chain chain;
+    for (int i = 0; i < 100; ++i) {
+        chain.insert(i);
+    }
+    EXPECT_EQ(chain.height(), 100);
+    EXPECT_TRUE(chain.validate());
+    TreeStats chain_stats = chain.stats();
+    EXPECT_EQ(chain_stats.inserts_, 100);
+    EXPECT_EQ(chain_stats.max_depth_, 100);
+    EXPECT_DOUBLE_EQ(chain_stats.average_depth(), 50.5);
+    EXPECT_EQ(chain_stats.allocations_, 100);
+    EXPECT_EQ(chain_stats.rotations_, 0);
+    chain.reset_stats();
+    EXPECT_TRUE(chain.contains(99));
+    EXPECT_EQ(chain.stats().lookups_, 1);
+    EXPECT_EQ(chain.stats().comparisons_per_lookup(), 100);
+
+    Balanced tree;
+    for (int i = 0; i < 1000; ++i) {
+        tree.insert(i);
+    }
+    EXPECT_LE(tree.height(), 2 * std::bit_width(tree.size() + 1));
+    EXPECT_GT(tree.stats().rotations_, 0);
+    EXPECT_TRUE(tree.validate());
+    tree.reset_stats();
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_NE(tree.find(i), tree.end());
+    }
+    EXPECT_EQ(tree.stats().lookups_, 1000);
+    EXPECT_LE(tree.stats().comparisons_per_lookup(), tree.height());
+
+    for (int i = 0; i < 1000; i += 3) {
+        tree.erase(tree.find(i));
+    }
+    tree.erase(tree.lower_bound(100), tree.lower_bound(900));
+    EXPECT_TRUE(tree.validate());
+    TreeStats stats = tree.stats();
+    EXPECT_EQ(stats.erases_, 1000 - tree.size());
+    EXPECT_EQ(stats.deallocations_, stats.erases_);
+    tree.clear();
+    EXPECT_EQ(tree.stats().deallocations_, 1000);
+    EXPECT_TRUE(tree.validate());
+}
+
+/**
+ * @brief Tests split() and join() relinking nodes for each policy.
+ */
+TEST(BST, split_join) {
+    using Tree = BST<int, std::less<int>, std::allocator<int>, RedBlack, SubtreeSize>;
+    Tree bst;
+    std::vector<int> reference;
+    for (int i = 0; i < 1000; ++i) {
+        bst.insert(i * 7919 % 500);
+        reference.push_back(i * 7919 % 500);
+    }
+    std::sort(reference.begin(), reference.end());
+    const int* first = &*bst.find(250);
+
+    auto [low, high] = bst.split(250);
+    EXPECT_TRUE(bst.empty());
+    EXPECT_TRUE(low.validate());
+    EXPECT_TRUE(high.validate());
+    EXPECT_EQ(low.size(), 500);
+    EXPECT_EQ(*--low.end(), 249);
+    EXPECT_EQ(&*high.begin(), first); // Nodes are relinked, not copied
+    EXPECT_EQ(low.rank(100), 200);
+
+    EXPECT_THROW(Tree::join(std::move(high), std::move(low)), std::invalid_argument);
+    EXPECT_EQ(high.size(), 500);
+    bst = Tree::join(std::move(low), std::move(high));
+    EXPECT_TRUE(low.empty());
+    EXPECT_TRUE(high.empty());
+    EXPECT_TRUE(bst.validate());
+    std::vector<int> joined;
+    for (int value : bst) {
+        joined.push_back(value);
+    }
+    EXPECT_EQ(joined, reference);
+
+    // Joining very different heights, and the unbalanced policy.
+    auto [none, all] = bst.split(-1);
+    EXPECT_TRUE(none.empty());
+    Tree tail = {1000, 1001};
+    bst = Tree::join(std::move(all), std::move(tail));
+    EXPECT_TRUE(bst.validate());
+    EXPECT_EQ(bst.size(), 1002);
+    EXPECT_EQ(*--bst.end(), 1001);
+
+    BST<int> chain;
+    for (int i = 0; i < 10; ++i) {
+        chain.insert(i);
+    }
+    auto [front, back] = chain.split(5);
+    EXPECT_EQ(front.size(), 5);
+    EXPECT_EQ(*back.begin(), 5);
+    chain = BST<int>::join(std::move(front), std::move(back));
+    EXPECT_TRUE(chain.validate());
+    EXPECT_EQ(chain.size(), 10);
+}
+
+/**
+ * @brief Tests erasing long runs of duplicates and bulk In-order ranges.
+ */
+TEST(BST, erase_bulk) {
+    BST<int, std::less<int>, std::allocator<int>, RedBlack, SubtreeSize> bst;
+    std::multiset<int> reference;
+    for (int i = 0; i < 3000; ++i) {
+        int value = i % 3 == 0 ? 42 : (i * 7919) % 1000;
+        bst.insert(value);
+        reference.insert(value);
+    }
+    EXPECT_EQ(bst.erase(42), reference.erase(42));
+    EXPECT_EQ(bst.erase(42), 0);
+    EXPECT_EQ(bst.erase(7), reference.erase(7)); // Short run, unlinked in place
+
+    // Iterators outside the erased range stay valid
+    auto first = bst.lower_bound(100);
+    auto last = bst.lower_bound(900);
+    bst.erase(first, last);
+    reference.erase(reference.lower_bound(100), reference.lower_bound(900));
+    EXPECT_EQ(*last, *reference.lower_bound(900));
+    std::vector<int> actual;
+    for (int value : bst) {
+        actual.push_back(value);
+    }
+    EXPECT_EQ(actual, std::vector<int>(reference.begin(), reference.end()));
+    EXPECT_EQ(bst.size(), reference.size());
+    EXPECT_EQ(*bst.nth(150), *std::next(reference.begin(), 150));
+
+    bst.erase(bst.cbegin(), bst.cend());
+    EXPECT_TRUE(bst.empty());
+}
+
+/**
+ * @brief Tests the index-linked CompactBST against std::multiset.
+ */
+TEST(BST, compact_tree) {
+    EXPECT_EQ(CompactBST<int>::node_size(), 16);
+
+    CompactBST<int> tree = {5, 3, 8, 3};
+    std::multiset<int> reference = {5, 3, 8, 3};
+    for (int i = 0; i < 2000; ++i) {
+        int value = (i * 7919) % 613;
+        tree.insert(value);
+        reference.insert(value);
+    }
+    for (int i = 0; i < 613; i += 3) {
+        EXPECT_EQ(tree.erase(i), reference.erase(i));
+    }
+    auto it = tree.find(4);
+    ASSERT_NE(it, tree.end());
+    auto next = tree.erase(it);
+    reference.erase(reference.find(4));
+    EXPECT_EQ(*next, *reference.upper_bound(3));
+
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_TRUE(std::equal(tree.begin(), tree.end(), reference.begin(),
+                           reference.end()));
+    EXPECT_EQ(*std::prev(tree.end()), *reference.rbegin());
+    EXPECT_EQ(tree.count(5), reference.count(5));
+    EXPECT_EQ(*tree.lower_bound(300), *reference.lower_bound(300));
+    EXPECT_EQ(*tree.upper_bound(300), *reference.upper_bound(300));
+    EXPECT_FALSE(tree.contains(0));
+
+    // Index links make the tree relocatable by plain copies
+    CompactBST<int> copy = tree;
+    EXPECT_EQ(copy, tree);
+    copy.clear();
+    EXPECT_TRUE(copy.empty());
+    EXPECT_NE(copy, tree);
+}
+
+/**
+ * @brief Tests the B+ tree BTreeBST against std::multiset, with small nodes
+ * so that splits, borrows and merges reach several levels.
+ */
+TEST(BST, btree_tree) {
+    BTreeBST<int, std::less<int>, std::allocator<int>, 64> tree = {5, 3, 8, 3};
+    std::multiset<int> reference = {5, 3, 8, 3};
+    for (int i = 0; i < 5000; ++i) {
+        int value = (i * 7919) % 1613;
+        tree.insert(value);
+        reference.insert(value);
+    }
+    EXPECT_GE(tree.height(), 3);
+    for (int i = 0; i < 1613; i += 3) {
+        EXPECT_EQ(tree.erase(i), reference.erase(i));
+    }
+    auto it = tree.find(4);
+    ASSERT_NE(it, tree.end());
+    auto next = tree.erase(it);
+    reference.erase(reference.find(4));
+    EXPECT_EQ(*next, *reference.upper_bound(3));
+
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_TRUE(std::equal(tree.begin(), tree.end(), reference.begin(),
+                           reference.end()));
+    EXPECT_TRUE(std::equal(std::make_reverse_iterator(tree.end()),
+                           std::make_reverse_iterator(tree.begin()),
+                           reference.rbegin(), reference.rend()));
+    EXPECT_EQ(tree.count(5), reference.count(5));
+    for (int key : {-1, 0, 300, 1611, 1612}) {
+        auto lower = tree.lower_bound(key);
+        auto upper = tree.upper_bound(key);
+        EXPECT_EQ(lower == tree.end(), reference.lower_bound(key) == reference.end());
+        EXPECT_EQ(upper == tree.end(), reference.upper_bound(key) == reference.end());
+        if (lower != tree.end()) {
+            EXPECT_EQ(*lower, *reference.lower_bound(key));
+        }
+        if (upper != tree.end()) {
+            EXPECT_EQ(*upper, *reference.upper_bound(key));
+        }
+    }
+    EXPECT_FALSE(tree.contains(0));
+
+    auto copy = tree;
+    EXPECT_EQ(copy, tree);
+    auto moved = std::move(copy);
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(moved, tree);
+    while (!tree.empty()) {
+        tree.erase(tree.begin());
+    }
+    EXPECT_EQ(tree.height(), 0);
+    EXPECT_NE(moved, tree);
+
+    // Non-trivial elements are moved, not copied, between slots
+    BTreeBST<std::string, std::less<>, std::allocator<std::string>, 128> words;
+    for (int i = 0; i < 500; ++i) {
+        words.insert(std::to_string(i * 37 % 500));
+    }
+    EXPECT_EQ(words.erase("250"), 1);
+    EXPECT_TRUE(words.contains(std::string_view("499"))); // Transparent lookup
+    EXPECT_EQ(words.size(), 499);
+    EXPECT_EQ(*words.begin(), "0");
+
+    // Nodes only change owner between equal allocators; otherwise the
+    // elements move into nodes of the target's allocator
+    using Tagged = BTreeBST<int, std::less<int>, TaggedAllocator<int>, 64>;
+    static_assert(std::is_nothrow_move_assignable_v<BTreeBST<int>>);
+    static_assert(!std::is_nothrow_move_assignable_v<Tagged>);
+    Tagged one(std::less<int>(), TaggedAllocator<int>(1));
+    Tagged two(std::less<int>(), TaggedAllocator<int>(2));
+    for (int i = 0; i < 100; ++i) {
+        one.insert(i);
+    }
+    two.insert(7);
+    two = std::move(one);
+    EXPECT_EQ(two.get_allocator().id_, 2);
+    EXPECT_TRUE(one.empty());
+    EXPECT_TRUE(std::ranges::equal(two, std::views::iota(0, 100)));
+    Tagged same(std::less<int>(), TaggedAllocator<int>(2));
+    const int* element = &*two.find(50);
+    same = std::move(two);
+    EXPECT_EQ(&*same.find(50), element);
+    Tagged copied(std::less<int>(), TaggedAllocator<int>(3));
+    copied = same;
+    EXPECT_EQ(copied.get_allocator().id_, 3);
+    EXPECT_EQ(copied, same);
+}
+
+/**
+ * @brief Element whose copies throw once a budget runs out (-1: unlimited).
+ */
+struct Fragile {
+    static inline int copies_left_ = -1;
+    int value_ = 0;
+
+    Fragile(int value) : value_(value) {}
+    Fragile(const Fragile& other) : value_(other.value_) {
+        if (copies_left_ == 0) {
+            throw std::runtime_error("copy");
+        }
+        if (copies_left_ > 0) {
+            --copies_left_;
+        }
+    }
+    Fragile(Fragile&&) noexcept = default;
+    Fragile& operator=(const Fragile&) = default;
+    Fragile& operator=(Fragile&&) noexcept = default;
+    auto operator<=>(const Fragile&) const = default;
+};
+
+/**
+ * @brief Tests that a throwing split leaves BTreeBST unchanged, and that
+ * the under-full last leaf left by appends survives erases.
+ */
+TEST(BST, btree_failures) {
+    BTreeBST<Fragile, std::less<Fragile>, std::allocator<Fragile>, 64> tree;
+    std::multiset<Fragile> reference;
+    for (int i = 0; i < 3000; ++i) {
+        // Alternate appends with inserts in the middle; every third one may
+        // not copy at all, so the separator copy of any split it needs throws
+        int value = i % 2 == 0 ? i : (i * 7919) % 1613;
+        Fragile::copies_left_ = i % 3;
+        try {
+            tree.insert(Fragile(value));
+            reference.insert(Fragile(value));
+        } catch (const std::runtime_error&) {
+        }
+        Fragile::copies_left_ = -1;
+        ASSERT_EQ(tree.size(), reference.size());
+    }
+    EXPECT_GE(tree.height(), 3);
+    EXPECT_TRUE(std::equal(tree.begin(), tree.end(), reference.begin(),
+                           reference.end()));
+    for (int i = 0; i < 1613; i += 5) {
+        EXPECT_EQ(tree.contains(Fragile(i)), reference.contains(Fragile(i)));
+    }
+
+    BTreeBST<int, std::less<int>, std::allocator<int>, 64> sorted;
+    std::multiset<int> expected;
+    for (int i = 0; i < 1000; ++i) {
+        sorted.insert(i);
+        expected.insert(i);
+        if (i % 50 == 1) {
+            // The last leaf now holds a single key or two
+            EXPECT_EQ(sorted.erase(i - 2), expected.erase(i - 2));
+            EXPECT_EQ(*std::prev(sorted.end()), i);
+        }
+    }
+    for (int i = 999; i > 0; i -= 3) {
+        EXPECT_EQ(sorted.erase(i), expected.erase(i));
+        ASSERT_EQ(*std::prev(sorted.end()), *expected.rbegin());
+    }
+    EXPECT_TRUE(std::equal(sorted.begin(), sorted.end(), expected.begin(),
+                           expected.end()));
+    while (!sorted.empty()) {
+        sorted.erase(std::prev(sorted.end()));
+    }
+    EXPECT_EQ(sorted.height(), 0);
+}
+
+/**
+ * @brief Tests freeze() snapshots against the mutable tree.
+ */
+TEST(BST, freeze) {
+    EXPECT_TRUE(BST<int>().freeze().empty());
+
+    for (int n : {1, 2, 7, 8, 100, 1023, 1024}) {
+        BST<int, std::less<int>, std::allocator<int>, RedBlack> bst;
+        for (int i = 0; i < n; ++i) {
+            bst.insert((i * 37) % n * 2); // Even values, odd ones are misses
+            bst.insert(i % 3 * 2);        // A few duplicates
+        }
+        auto frozen = bst.freeze();
+        ASSERT_EQ(frozen.size(), bst.size());
+        std::vector<int> expected;
+        for (int value : bst) {
+            expected.push_back(value);
+        }
+        EXPECT_TRUE(std::equal(frozen.begin(), frozen.end(), expected.begin(),
+                               expected.end()));
+        EXPECT_EQ(*std::prev(frozen.end()), expected.back());
+        for (int key = -1; key <= 2 * n + 1; ++key) {
+            auto lower = frozen.lower_bound(key);
+            auto upper = frozen.upper_bound(key);
+            auto expected_lower = std::lower_bound(expected.begin(), expected.end(), key);
+            auto expected_upper = std::upper_bound(expected.begin(), expected.end(), key);
+            EXPECT_EQ(lower == frozen.end(), expected_lower == expected.end());
+            if (lower != frozen.end()) {
+                EXPECT_EQ(*lower, *expected_lower);
+            }
+            EXPECT_EQ(upper == frozen.end(), expected_upper == expected.end());
+            if (upper != frozen.end()) {
+                EXPECT_EQ(*upper, *expected_upper);
+            }
+            EXPECT_EQ(frozen.contains(key), bst.contains(key));
+            EXPECT_EQ(frozen.count(key), bst.count(key));
+        }
+    }
+
+    // Iterators belong to the shared elements, not to the snapshot object
+    auto source = BST<int>{1, 2, 3}.freeze();
+    auto first = source.begin();
+    auto last = std::prev(source.end());
+    FrozenBST<int> moved = std::move(source);
+    {
+        FrozenBST<int> copy = moved;
+        moved = FrozenBST<int>();
+        EXPECT_EQ(*first, 1);
+        EXPECT_EQ(*std::next(first, 2), 3);
+        EXPECT_EQ(std::next(last), copy.end());
+        EXPECT_EQ(*--copy.end(), *last);
+    }
+}
+
+/**
+ * @brief Tests find_batch() and contains_batch() against single lookups.
+ */
+TEST(BST, batched_lookup) {
+    BST<int, std::less<int>, std::allocator<int>, RedBlack> bst;
+    CompactBST<int> compact;
+    for (int i = 0; i < 500; ++i) {
+        bst.insert(i * 3 % 500 * 2);
+        compact.insert(i * 3 % 500 * 2);
+    }
+    std::vector<int> keys;
+    for (int key = -3; key < 1010; key += 3) {
+        keys.push_back(key);
+    }
+    auto frozen = bst.freeze();
+
+    std::vector<decltype(bst)::iterator> found(keys.size());
+    std::vector<decltype(frozen)::iterator> frozen_found(keys.size());
+    std::vector<CompactBST<int>::iterator> compact_found(keys.size());
+    std::unique_ptr<bool[]> flags(new bool[keys.size()]);
+    bst.find_batch(keys, found);
+    frozen.find_batch(keys, frozen_found);
+    compact.find_batch(keys, compact_found);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(found[i], bst.find(keys[i]));
+        EXPECT_EQ(frozen_found[i], frozen.find(keys[i]));
+        EXPECT_EQ(compact_found[i], compact.find(keys[i]));
+    }
+
+    std::span<bool> out(flags.get(), keys.size());
+    bst.contains_batch(keys, out);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(out[i], keys[i] >= 0 && keys[i] < 1000 && keys[i] % 2 == 0);
+    }
+    auto hits = std::count(out.begin(), out.end(), true);
+    frozen.contains_batch(keys, out);
+    EXPECT_EQ(std::count(out.begin(), out.end(), true), hits);
+    compact.contains_batch(keys, out);
+    EXPECT_EQ(std::count(out.begin(), out.end(), true), hits);
+
+    // Empty trees answer every key with end()
+    decltype(bst) empty;
+    empty.find_batch(keys, std::span(found).first(3));
+    EXPECT_EQ(found[0], empty.end());
+}
+
+/**
+ * @brief Tests ConcurrentBST readers running alongside a writer.
+ */
+TEST(BST, concurrent_readers) {
+    ConcurrentBST<int> tree = {-1};
+    std::atomic<bool> done{false};
+    std::atomic<size_t> inconsistent{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&] {
+            while (!done.load()) {
+                // Every version holds a prefix -1, 0, ..., n - 2 of the inserts
+                tree.read([&](const auto& bst) {
+                    int expected = -1;
+                    for (auto it = bst.cbegin(); it != bst.cend(); ++it) {
+                        inconsistent += *it != expected++;
+                    }
+                    inconsistent += static_cast<size_t>(expected + 1) != bst.size();
+                });
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (int i = 0; i < 300; ++i) {
+        tree.insert(i);
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(tree.erase(-1), 1);
+    EXPECT_EQ(inconsistent.load(), 0);
+    EXPECT_EQ(tree.size(), 300);
+    EXPECT_TRUE(tree.contains(299));
+    EXPECT_FALSE(tree.contains(-1));
+
+    // A throwing update leaves both copies as they were
+    EXPECT_THROW(tree.write([](auto& bst) {
+        bst.insert(5000);
+        throw std::runtime_error("abort");
+    }), std::runtime_error);
+    EXPECT_EQ(tree.count(5000), 0);
+    tree.insert(7);
+    EXPECT_EQ(tree.snapshot().count(7), 2);
+}
+
+/**
+ * @brief Stateful, non-copyable visitor: parallel traversals must call it
+ * by reference.
+ */
+struct VisitCounter {
+    std::atomic<size_t> calls_{0};
+
+    void operator()(const int&) { ++calls_; }
+};
+
+/**
+ * @brief Tests ShardedBST writers, merged iteration, bulk operations and
+ * rebalance().
+ */
+TEST(BST, sharded_tree) {
+    std::vector<int> bounds = {250, 500, 750};
+    ShardedBST<int, std::less<int>, PoolAllocator<int>, 4> tree(bounds);
+    std::vector<std::thread> writers;
+    for (int w = 0; w < 4; ++w) {
+        writers.emplace_back([&, w] {
+            for (int i = w; i < 1000; i += 4) {
+                tree.insert(i);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(tree.size(), 1000);
+    for (size_t shard = 0; shard < 4; ++shard) {
+        EXPECT_EQ(tree.shard_size(shard), 250);
+    }
+    EXPECT_TRUE(std::ranges::equal(tree, std::views::iota(0, 1000)));
+    EXPECT_EQ(*std::prev(tree.end()), 999);
+    EXPECT_EQ(*std::prev(tree.end(), 251), 749);
+
+    std::vector<int> batch = {900, 3, 260, 260, -5};
+    tree.insert_batch(batch, Parallel{2});
+    EXPECT_EQ(tree.count(260), 3);
+    EXPECT_EQ(*tree.begin(), -5);
+    EXPECT_EQ(tree.erase(260), 3);
+    EXPECT_FALSE(tree.contains(260));
+    EXPECT_TRUE(std::is_sorted(tree.begin(), tree.end()));
+
+    std::atomic<long long> sum{0};
+    tree.parallel_for_each(Parallel{2}, [&](int value) { sum += value; });
+    long long expected = 0;
+    tree.for_each([&](int value) { expected += value; });
+    EXPECT_EQ(sum.load(), expected);
+    VisitCounter counter;
+    tree.parallel_for_each(Parallel{2}, counter);
+    tree.parallel_for_each(Sequential(), counter);
+    EXPECT_EQ(counter.calls_.load(), 2 * tree.size());
+
+    // Without bounds everything lands in one shard until rebalance()
+    ShardedBST<int, std::less<int>, PoolAllocator<int>, 4> skewed;
+    for (int i = 0; i < 400; ++i) {
+        skewed.insert(i % 100);
+    }
+    EXPECT_EQ(skewed.shard_size(0), 400);
+    skewed.rebalance();
+    EXPECT_EQ(skewed.bounds().size(), 3);
+    for (size_t shard = 0; shard < 4; ++shard) {
+        EXPECT_EQ(skewed.shard_size(shard), 100);
+    }
+    EXPECT_EQ(skewed.count(50), 4);
+    EXPECT_TRUE(std::is_sorted(skewed.begin(), skewed.end()));
+
+    // A rebuild that throws midway leaves the old shards and bounds
+    ShardedBST<Fragile, std::less<Fragile>, PoolAllocator<Fragile>, 4> fragile;
+    for (int i = 0; i < 400; ++i) {
+        fragile.insert(Fragile(i));
+    }
+    Fragile::copies_left_ = 400 + 150;
+    EXPECT_THROW(fragile.rebalance(), std::runtime_error);
+    Fragile::copies_left_ = -1;
+    EXPECT_TRUE(fragile.bounds().empty());
+    EXPECT_EQ(fragile.shard_size(0), 400);
+    EXPECT_TRUE(fragile.contains(Fragile(399)));
+    fragile.rebalance();
+    EXPECT_EQ(fragile.bounds().size(), 3);
+    EXPECT_EQ(fragile.count(Fragile(399)), 1);
+    skewed.clear();
+    EXPECT_TRUE(skewed.empty());
+    EXPECT_EQ(skewed.begin(), skewed.end());
+
+    // Walking backward crosses empty shards without running off the first
+    std::vector<int> tens = {10, 20, 30};
+    ShardedBST<int, std::less<int>, PoolAllocator<int>, 4> tail(tens);
+    for (int value : {32, 30, 31}) {
+        tail.insert(value);
+    }
+    EXPECT_EQ(std::prev(tail.end(), 3), tail.begin());
+    EXPECT_TRUE(std::ranges::equal(std::ranges::reverse_view(tail),
+                                   std::vector<int>{32, 31, 30}));
+    tail.insert(5); // Shards 1 and 2 stay empty between the two in use
+    EXPECT_EQ(*std::prev(tail.end(), 3), 30);
+    EXPECT_EQ(std::prev(tail.end(), 4), tail.begin());
+    EXPECT_EQ(*tail.begin(), 5);
+
+    std::vector<int> unsorted = {5, 1};
+    using Sharded = ShardedBST<int, std::less<int>, PoolAllocator<int>, 2>;
+    EXPECT_THROW(Sharded{std::span<const int>(unsorted)}, std::invalid_argument);
+}
+
+/**
+ * @brief Tests parallel_for_each() and parallel_reduce() against a serial scan.
+ */
+TEST(BST, parallel_traversal) {
+    BST<int, std::less<int>, std::allocator<int>, RedBlack, SubtreeSize> sized;
+    BST<int> chain;
+    long long expected = 0;
+    for (int i = 0; i < 5000; ++i) {
+        sized.insert(i * 7 % 5000);
+        expected += i;
+    }
+    for (int i = 0; i < 300; ++i) {
+        chain.emplace_hint(chain.end(), i); // Degenerate shape
+    }
+
+    std::atomic<long long> sum{0};
+    std::atomic<size_t> visits{0};
+    sized.parallel_for_each(Parallel{4}, [&](const int& value) {
+        sum += value;
+        ++visits;
+    });
+    EXPECT_EQ(sum.load(), expected);
+    EXPECT_EQ(visits.load(), sized.size());
+    VisitCounter counter; // One visitor shared by all threads keeps its state
+    sized.parallel_for_each(Parallel{4}, counter);
+    sized.parallel_for_each(Sequential(), counter);
+    EXPECT_EQ(counter.calls_.load(), 2 * sized.size());
+
+    auto plus = [](long long a, long long b) { return a + b; };
+    EXPECT_EQ(sized.parallel_reduce(Parallel{4}, 0LL, plus), expected);
+    EXPECT_EQ(sized.parallel_reduce(Sequential(), 0LL, plus), expected);
+
+    // Non-commutative reduce keeps the In-order sequence
+    auto concat = [](std::string a, const std::string& b) { return a + b; };
+    auto digit = [](int value) { return std::to_string(value % 10); };
+    std::string serial = chain.parallel_reduce(Sequential(), std::string(), concat, digit);
+    EXPECT_EQ(chain.parallel_reduce(Parallel{3}, std::string(), concat, digit), serial);
+    EXPECT_EQ(serial.size(), 300);
+
+    // Exceptions from workers reach the caller
+    EXPECT_THROW(sized.parallel_for_each(Parallel{4}, [](int value) {
+        if (value == 1234) {
+            throw std::runtime_error("stop");
+        }
+    }), std::runtime_error);
+
+    EXPECT_EQ(BST<int>().parallel_reduce(Parallel{4}, 5, plus), 5);
+}
+
+/**
+ * @brief Tests that PersistentBST versions are independent and share nodes.
+ */
+TEST(BST, persistent_versions) {
+    PersistentBST<int> tree;
+    std::multiset<int> reference;
+    for (int i = 0; i < 1000; ++i) {
+        tree.insert(i * 7919 % 300);
+        reference.insert(i * 7919 % 300);
+    }
+    EXPECT_LE(tree.height(), 15); // AVL bound 1.44 log2(n)
+
+    PersistentBST<int> snapshot = tree.snapshot();
+    EXPECT_TRUE(snapshot.shares_root(tree));
+    std::multiset<int> frozen = reference;
+
+    for (int i = 0; i < 300; i += 2) {
+        EXPECT_EQ(tree.erase(i), reference.erase(i));
+    }
+    tree.insert(1000);
+    reference.insert(1000);
+
+    // The snapshot still sees the old version
+    EXPECT_TRUE(std::equal(snapshot.begin(), snapshot.end(), frozen.begin(),
+                           frozen.end()));
+    EXPECT_TRUE(std::equal(tree.begin(), tree.end(), reference.begin(),
+                           reference.end()));
+    EXPECT_EQ(tree.size(), reference.size());
+    EXPECT_EQ(snapshot.size(), frozen.size());
+    EXPECT_FALSE(tree.contains(0));
+    EXPECT_TRUE(snapshot.contains(0));
+    EXPECT_EQ(snapshot.count(4), frozen.count(4));
+    EXPECT_EQ(*tree.lower_bound(2), 3);
+    EXPECT_EQ(tree.find(2), tree.end());
+
+    // A failed erase keeps the version as is
+    PersistentBST<int> before = tree;
+    EXPECT_EQ(tree.erase(-5), 0);
+    EXPECT_TRUE(tree.shares_root(before));
+    EXPECT_NE(tree, snapshot);
+}
+
+/**
+ * @brief Tests binary save/load round trips and memory-mapped snapshots.
+ */
+TEST(BST, snapshot_files) {
+    BST<int> tree;
+    for (int i = 0; i < 10000; ++i) {
+        tree.insert(i * 7919 % 10000 / 2);
+    }
+    std::stringstream stream;
+    tree.save(stream);
+    auto loaded = BST<int>::load(stream);
+    EXPECT_EQ(loaded, tree);
+
+    std::stringstream empty;
+    BST<int>().save(empty);
+    EXPECT_TRUE(BST<int>::load(empty).empty());
+
+    auto frozen = tree.freeze();
+    auto path = (std::filesystem::temp_directory_path() / "bst_snapshot_test.bin").string();
+    frozen.save(path);
+    auto mapped = FrozenBST<int>::mmap_open(path);
+    EXPECT_EQ(mapped, frozen);
+    EXPECT_EQ(FrozenBST<int>::load(path), frozen);
+    auto copy = mapped;
+    mapped = FrozenBST<int>();
+    EXPECT_EQ(copy.count(42), tree.count(42));
+    EXPECT_FALSE(copy.contains(5000));
+
+    // A frozen file is not a sorted one, and neither survives corruption.
+    EXPECT_THROW(BST<int>::load(path), std::runtime_error);
+    std::string bytes = stream.str();
+    bytes[0] = 'X';
+    std::stringstream corrupted(bytes);
+    EXPECT_THROW(BST<int>::load(corrupted), std::runtime_error);
+    std::stringstream truncated(stream.str().substr(0, 100));
+    EXPECT_THROW(BST<int>::load(truncated), std::runtime_error);
+    std::stringstream reversed;
+    BST<int, std::greater<int>> descending{3, 2, 1};
+    descending.save(reversed);
+    EXPECT_THROW(BST<int>::load(reversed), std::runtime_error);
+
+    // Forged counts and misordered layouts are rejected, not trusted.
+    std::stringstream small;
+    BST<int>{1, 2, 3}.freeze().save(small);
+    for (uint64_t count : {uint64_t(1) << 28, uint64_t(1) << 62}) {
+        std::string forged = small.str();
+        std::memcpy(forged.data() + offsetof(SnapshotHeader, count_), &count,
+                    sizeof(count));
+        std::stringstream in(forged);
+        EXPECT_THROW(FrozenBST<int>::load(in), std::runtime_error);
+    }
+    std::string misordered = small.str();
+    const int descending_layout[] = {3, 2, 1};
+    std::memcpy(misordered.data() + sizeof(SnapshotHeader), descending_layout,
+                sizeof(descending_layout));
+    std::stringstream misordered_in(misordered);
+    EXPECT_THROW(FrozenBST<int>::load(misordered_in), std::runtime_error);
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << misordered;
+    EXPECT_THROW(FrozenBST<int>::mmap_open(path), std::runtime_error);
+    std::filesystem::remove(path);
+}